@@ -0,0 +1,162 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+double BenchmarkResult::percentile(double fraction) const
+{
+    std::vector<double> sorted = nanoseconds;
+    std::sort(sorted.begin(), sorted.end());
+    int index = static_cast<int>(std::round(fraction * (sorted.size() - 1)));
+    return sorted[index];
+}
+
+double BenchmarkResult::mean() const
+{
+    return std::accumulate(nanoseconds.begin(), nanoseconds.end(), 0.0) / nanoseconds.size();
+}
+
+Benchmark::Benchmark(std::string filter, double minimumSeconds)
+    : m_filter(std::move(filter))
+    , m_minimumSeconds(minimumSeconds)
+{
+}
+
+bool Benchmark::isEnabled(const std::string& name) const
+{
+    return name.find(m_filter) != std::string::npos;
+}
+
+void Benchmark::run(
+    const std::string& name,
+    const BenchmarkParameters& parameters,
+    double itemsPerIteration,
+    const std::function<void()>& body,
+    const std::function<void()>& setup)
+{
+    if (!isEnabled(name)) {
+        return;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    for (int i = 0; i < k_warmUpIterations; i++) {
+        if (setup) {
+            setup();
+        }
+        body();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.itemsPerIteration = itemsPerIteration;
+    double elapsedSeconds = 0;
+    while (static_cast<int>(result.nanoseconds.size()) < k_maximumIterations
+        && (elapsedSeconds < m_minimumSeconds
+            || static_cast<int>(result.nanoseconds.size()) < k_minimumIterations)) {
+        if (setup) {
+            setup();
+        }
+        Clock::time_point start = Clock::now();
+        body();
+        double nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        result.nanoseconds.push_back(nanoseconds);
+        elapsedSeconds += nanoseconds * 1e-9;
+    }
+    m_results.push_back(std::move(result));
+}
+
+void Benchmark::addMetric(const std::string& name, double value)
+{
+    if (!m_results.empty()) {
+        m_results.back().metrics.emplace_back(name, value);
+    }
+}
+
+void Benchmark::check(const std::string& name, bool passed, const std::string& detail)
+{
+    if (!passed) {
+        std::cerr << "FAILED " << name << ": " << detail << std::endl;
+        m_numFailures++;
+    }
+}
+
+static void writeObject(std::ostream& stream, const BenchmarkParameters& values)
+{
+    stream << "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        stream << (i ? ", " : "") << "\"" << values[i].first << "\": " << values[i].second;
+    }
+    stream << "}";
+}
+
+void Benchmark::writeJSON(std::ostream& stream) const
+{
+    stream << "{\n  \"build\": {";
+#if defined(__VERSION__)
+    stream << "\"compiler\": \"" << __VERSION__ << "\", ";
+#endif
+#ifdef NICESCOPE_DOUBLE_PRECISION_FFT
+    stream << "\"fft_precision\": \"double\", ";
+#else
+    stream << "\"fft_precision\": \"single\", ";
+#endif
+#if defined(__AVX2__)
+    stream << "\"simd\": \"avx2\"";
+#elif defined(__SSE2__)
+    stream << "\"simd\": \"sse2\"";
+#else
+    stream << "\"simd\": \"none\"";
+#endif
+    stream << "},\n  \"results\": [\n";
+
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const BenchmarkResult& result = m_results[i];
+        double mean = result.mean();
+        stream << "    {\"name\": \"" << result.name << "\", \"parameters\": ";
+        writeObject(stream, result.parameters);
+        stream << ", \"iterations\": " << result.nanoseconds.size()
+               << ", \"items_per_iteration\": " << result.itemsPerIteration
+               << ", \"items_per_second\": " << result.itemsPerIteration / (mean * 1e-9)
+               << ", \"ns\": ";
+        writeObject(stream, {
+                                { "mean", mean },
+                                { "min", result.percentile(0) },
+                                { "p50", result.percentile(0.5) },
+                                { "p90", result.percentile(0.9) },
+                                { "p99", result.percentile(0.99) },
+                                { "max", result.percentile(1) },
+                            });
+        stream << ", \"metrics\": ";
+        writeObject(stream, result.metrics);
+        stream << "}" << (i + 1 < m_results.size() ? "," : "") << "\n";
+    }
+    stream << "  ]\n}\n";
+}
+
+void Benchmark::printSummary(std::ostream& stream) const
+{
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-28s %-44s %11s %11s %11s\n", "stage", "parameters", "p50 us", "p99 us", "Mitems/s");
+    stream << line;
+    for (const BenchmarkResult& result : m_results) {
+        std::string parameters;
+        for (const auto& parameter : result.parameters) {
+            char value[64];
+            std::snprintf(value, sizeof(value), "%s=%g ", parameter.first.c_str(), parameter.second);
+            parameters += value;
+        }
+        std::snprintf(
+            line, sizeof(line), "%-28s %-44s %11.2f %11.2f %11.2f\n",
+            result.name.c_str(),
+            parameters.c_str(),
+            result.percentile(0.5) * 1e-3,
+            result.percentile(0.99) * 1e-3,
+            result.itemsPerIteration / (result.mean() * 1e-9) * 1e-6);
+        stream << line;
+    }
+}
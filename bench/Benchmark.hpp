@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<std::string, double>> BenchmarkParameters;
+
+struct BenchmarkResult {
+    std::string name;
+    BenchmarkParameters parameters;
+    // What one iteration processes (frames, bins, points...), for throughput.
+    double itemsPerIteration;
+    // Wall time of every timed iteration.
+    std::vector<double> nanoseconds;
+    // Anything else worth recording, e.g. accuracy.
+    BenchmarkParameters metrics;
+
+    double percentile(double fraction) const;
+    double mean() const;
+};
+
+// Times small pieces of code one iteration at a time, so results carry a
+// latency distribution and not just an average, and writes them as JSON.
+class Benchmark {
+public:
+    Benchmark(std::string filter, double minimumSeconds);
+
+    // True if name contains the filter string.
+    bool isEnabled(const std::string& name) const;
+
+    // Runs setup() then times body(), over and over, until both
+    // minimumSeconds and k_minimumIterations are reached. setup() is not
+    // timed; use it to feed the stage its next input.
+    void run(
+        const std::string& name,
+        const BenchmarkParameters& parameters,
+        double itemsPerIteration,
+        const std::function<void()>& body,
+        const std::function<void()>& setup = nullptr);
+
+    // Attaches a metric to the most recent result.
+    void addMetric(const std::string& name, double value);
+
+    // Records the outcome of a correctness check, reporting failures on
+    // stderr. Timing carries on either way, but the run counts as failed.
+    void check(const std::string& name, bool passed, const std::string& detail);
+    bool hasFailures() const { return m_numFailures > 0; }
+
+    void writeJSON(std::ostream& stream) const;
+    void printSummary(std::ostream& stream) const;
+
+private:
+    static const int k_warmUpIterations = 3;
+    static const int k_minimumIterations = 20;
+    static const int k_maximumIterations = 200000;
+
+    std::string m_filter;
+    double m_minimumSeconds;
+    std::vector<BenchmarkResult> m_results;
+    int m_numFailures = 0;
+};
@@ -0,0 +1,588 @@
+// Runs each pipeline stage in isolation against synthetic signals and
+// writes timings as JSON, so builds can be compared:
+//
+//     nicescope_bench [--output results.json] [--filter name] [--min-time seconds]
+//
+// A summary table goes to stderr. The kernels' results are also checked,
+// and the exit status is 1 if any check failed.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "CurveGeometry.hpp"
+#include "FFT.hpp"
+#include "MultiResolutionFFT.hpp"
+#include "Options.hpp"
+#include "Simd.hpp"
+#include "SlidingDFT.hpp"
+#include "Spectrum.hpp"
+#include "SpectrumAccumulators.hpp"
+#include "ZoomFFT.hpp"
+
+static const float k_sampleRate = 48000;
+static const int k_blockSize = 256;
+static const int k_windowWidth = 1920;
+static const int k_windowHeight = 1080;
+static const double k_pi = 3.14159265358979;
+// What Simd.hpp promises for simd::magnitudeToDb().
+static const double k_maxMagnitudeErrorDb = 1e-4;
+// For simd::dbToPower(): the exp2 polynomial's error plus rounding the
+// exponent, which grows with the level.
+static const double k_maxPowerRelativeError = 1e-5;
+// How far Spectrum::update() may stray from the per-bin reference. Both
+// round in float, the reference in a different order, and the angles
+// inherit that rounding wherever neighbouring levels nearly cancel in the
+// derivative.
+static const double k_maxSpectrumLevelError = 0.01;
+static const double k_maxSpectrumAngleError = 0.01;
+
+// Results are written here so the compiler cannot drop the work.
+static volatile float g_sink;
+
+// Interleaved frames of a few sines over white noise, a different mix per
+// channel. Wraps around, so any number of frames can be requested.
+class SyntheticSignal {
+public:
+    SyntheticSignal(int numChannels, int length)
+        : m_numChannels(numChannels)
+        , m_length(length)
+        , m_samples(numChannels * length)
+    {
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> noise(-0.01, 0.01);
+        for (int i = 0; i < length; i++) {
+            for (int channel = 0; channel < numChannels; channel++) {
+                float t = static_cast<float>(i) / k_sampleRate;
+                m_samples[i * numChannels + channel] = noise(random)
+                    + 0.5f * std::sin(2 * k_pi * (440 + 110 * channel) * t)
+                    + 0.1f * std::sin(2 * k_pi * 5000 * t);
+            }
+        }
+    }
+
+    // numFrames frames, at most the signal length.
+    const float* next(int numFrames)
+    {
+        if (m_position + numFrames > m_length) {
+            m_position = 0;
+        }
+        const float* frames = &m_samples[m_position * m_numChannels];
+        m_position += numFrames;
+        return frames;
+    }
+
+    void feed(Ingress& ingress, int numFrames)
+    {
+        while (numFrames > 0) {
+            int blockSize = std::min(numFrames, k_blockSize);
+            ingress.process(next(blockSize), nullptr, blockSize, 0, 0);
+            ingress.bufferSamples(blockSize);
+            numFrames -= blockSize;
+        }
+    }
+
+private:
+    const int m_numChannels;
+    const int m_length;
+    std::vector<float> m_samples;
+    int m_position = 0;
+};
+
+static std::vector<float> randomMagnitudes(int size)
+{
+    std::mt19937 random(5678);
+    std::uniform_real_distribution<float> level(-120, 0);
+    std::vector<float> magnitudes(size);
+    for (float& magnitude : magnitudes) {
+        magnitude = level(random);
+    }
+    return magnitudes;
+}
+
+static std::vector<float> fftBinFrequencies(int fftSize)
+{
+    std::vector<float> frequencies;
+    for (int i = 0; i < fftSize / 2 + 1; i++) {
+        frequencies.push_back(i * k_sampleRate / fftSize);
+    }
+    return frequencies;
+}
+
+static void benchIngress(Benchmark& benchmark)
+{
+    for (int numChannels : { 1, 2, 8 }) {
+        Ingress ingress(numChannels, 65536);
+        SyntheticSignal signal(numChannels, 65536);
+        BenchmarkParameters parameters = { { "channels", numChannels }, { "frames", k_blockSize } };
+        // Each stage's untimed setup runs the other one, so the ring never
+        // overflows or runs dry.
+        benchmark.run("ingress.process", parameters, k_blockSize, [&] {
+            ingress.process(signal.next(k_blockSize), nullptr, k_blockSize, 0, 0);
+        },
+            [&] { ingress.bufferSamples(k_blockSize); });
+        benchmark.run("ingress.bufferSamples", parameters, k_blockSize, [&] {
+            ingress.bufferSamples(k_blockSize);
+        },
+            [&] { ingress.process(signal.next(k_blockSize), nullptr, k_blockSize, 0, 0); });
+    }
+}
+
+static void benchFFT(Benchmark& benchmark)
+{
+    const int numChannels = 2;
+    for (int fftSize : { 512, 2048, 8192, 32768, 131072 }) {
+        if (!benchmark.isEnabled("fft.process")) {
+            return;
+        }
+        Ingress ingress(numChannels, fftSize);
+        SyntheticSignal signal(numChannels, 65536);
+        signal.feed(ingress, fftSize);
+        FFT fft(fftSize, numChannels, PlanEffort::Estimate);
+        benchmark.run("fft.process", { { "size", fftSize }, { "channels", numChannels } }, fftSize * numChannels, [&] {
+            fft.process(ingress);
+        });
+    }
+}
+
+// Cost per update of the sliding DFT against retransforming with FFT at
+// the same hop. The FFT's cost per update does not depend on the hop.
+static void benchSlidingDFT(Benchmark& benchmark)
+{
+    const int numChannels = 2;
+    const int fftSize = 2048;
+    for (int hopSize : { 64, 256, 1024 }) {
+        BenchmarkParameters parameters = { { "size", fftSize }, { "hop", hopSize }, { "channels", numChannels } };
+        Ingress ingress(numChannels, fftSize + hopSize);
+        SyntheticSignal signal(numChannels, 65536);
+        signal.feed(ingress, fftSize + hopSize);
+
+        if (benchmark.isEnabled("sdft.process")) {
+            SlidingDFT sdft(fftSize, numChannels, k_sampleRate, hopSize, 48, fftSize);
+            benchmark.run("sdft.process", parameters, hopSize, [&] {
+                sdft.process(ingress, hopSize, 0);
+            },
+                [&] { signal.feed(ingress, hopSize); });
+            benchmark.addMetric("bins", sdft.getSpectrumSize());
+        }
+        if (benchmark.isEnabled("sdft.fft_reference")) {
+            FFT fft(fftSize, numChannels, PlanEffort::Estimate);
+            benchmark.run("sdft.fft_reference", parameters, hopSize, [&] {
+                fft.process(ingress);
+            },
+                [&] { signal.feed(ingress, hopSize); });
+        }
+    }
+}
+
+static void benchEngines(Benchmark& benchmark)
+{
+    const int numChannels = 2;
+    if (benchmark.isEnabled("multires.process")) {
+        std::vector<AnalysisBand> bands = parseAnalysisBands(k_defaultMultiResolutionBands, k_sampleRate);
+        MultiResolutionFFT engine(bands, numChannels, k_sampleRate, 75, 2048, PlanEffort::Estimate);
+        Ingress ingress(numChannels, engine.getLongestWindow());
+        SyntheticSignal signal(numChannels, 65536);
+        signal.feed(ingress, engine.getLongestWindow());
+        int hopSize = engine.getHopSize();
+        benchmark.run("multires.process", { { "hop", hopSize }, { "channels", numChannels } }, hopSize, [&] {
+            engine.process(ingress, hopSize, 0);
+        },
+            [&] { signal.feed(ingress, hopSize); });
+    }
+    if (benchmark.isEnabled("zoom.process")) {
+        ZoomFFT engine(1000, 100, 1024, numChannels, k_sampleRate, 75, 2048, PlanEffort::Estimate);
+        Ingress ingress(numChannels, engine.getLongestWindow());
+        SyntheticSignal signal(numChannels, 65536);
+        int hopSize = engine.getHopSize();
+        benchmark.run("zoom.process", { { "center", 1000 }, { "span", 100 }, { "size", 1024 }, { "channels", numChannels } }, hopSize, [&] {
+            engine.process(ingress, hopSize, 0);
+        },
+            [&] { signal.feed(ingress, hopSize); });
+        benchmark.addMetric("decimation", engine.getDecimationFactor());
+    }
+}
+
+static void benchSpectralMaximum(Benchmark& benchmark)
+{
+    const int numChannels = 2;
+    for (int fftSize : { 2048, 32768, 262144 }) {
+        int spectrumSize = fftSize / 2 + 1;
+        std::vector<float> magnitudes = randomMagnitudes(numChannels * spectrumSize);
+        SpectralMaximum spectralMaximum(spectrumSize);
+        benchmark.run("spectralMaximum.process", { { "bins", spectrumSize }, { "channels", numChannels } }, spectrumSize, [&] {
+            spectralMaximum.process(magnitudes.data(), numChannels);
+            g_sink = spectralMaximum.getMaximum();
+        });
+    }
+}
+
+static void benchAccumulators(Benchmark& benchmark)
+{
+    AccumulatorSettings settings;
+    settings.peakHold = true;
+    settings.minimumHold = true;
+    settings.averageTime = 10;
+    settings.windowTime = 10;
+    for (int fftSize : { 2048, 32768 }) {
+        int spectrumSize = fftSize / 2 + 1;
+        std::vector<float> magnitudes = randomMagnitudes(spectrumSize);
+        SpectrumAccumulators accumulators(spectrumSize, settings);
+        // Spectra arrive at 75% overlap, so the window slots turn over
+        // as often as they would live.
+        float elapsed = fftSize / 4 / k_sampleRate;
+        benchmark.run("accumulators.process", { { "bins", spectrumSize }, { "traces", 4 } }, spectrumSize, [&] {
+            accumulators.process(magnitudes.data(), elapsed);
+        });
+    }
+}
+
+// Checks the accumulators' kernels against plain scalar code: conversions
+// within the bounds Simd.hpp promises, the peak hold exactly, since both
+// do the same float operations. Sizes are odd so the scalar tails run too.
+static void checkAccumulatorKernels(Benchmark& benchmark)
+{
+    const int n = 1027;
+    std::mt19937 random(1213);
+    std::uniform_real_distribution<float> level(-300, 100);
+    std::vector<float> db(n);
+    std::vector<float> out(n);
+    for (float& value : db) {
+        value = level(random);
+    }
+
+    simd::dbToPower(db.data(), out.data(), n);
+    double maximumRelativeError = 0;
+    for (int i = 0; i < n; i++) {
+        double reference = std::pow(10.0, db[i] / 10.0);
+        maximumRelativeError = std::max(maximumRelativeError, std::fabs(out[i] - reference) / reference);
+    }
+    benchmark.check(
+        "simd.dbToPower", maximumRelativeError <= k_maxPowerRelativeError,
+        "relative error of " + std::to_string(maximumRelativeError) + " is over " + std::to_string(k_maxPowerRelativeError));
+
+    // Powers of 1e-35 to 1e10, so some fall under the -300 dB clamp.
+    std::uniform_real_distribution<float> exponent(-35, 10);
+    std::vector<float> power(n);
+    for (float& value : power) {
+        value = std::pow(10.0f, exponent(random));
+    }
+    const float scale = 0.5f;
+    simd::powerToDb(power.data(), scale, out.data(), n);
+    double maximumError = 0;
+    for (int i = 0; i < n; i++) {
+        double reference = 10 * std::log10(std::max(static_cast<double>(power[i] * scale), 1e-30));
+        maximumError = std::max(maximumError, std::fabs(out[i] - reference));
+    }
+    benchmark.check(
+        "simd.powerToDb", maximumError <= k_maxMagnitudeErrorDb,
+        "error of " + std::to_string(maximumError) + " dB is over " + std::to_string(k_maxMagnitudeErrorDb));
+
+    // A minute of spectra 20 ms apart, the levels jumping around enough to
+    // set new peaks, hold them and let them fall.
+    const float elapsed = 0.02f;
+    const float holdTime = 0.5f;
+    const float fall = 20 * elapsed;
+    std::uniform_real_distribution<float> jump(-3, 2);
+    std::vector<float> peak(n, -1000);
+    std::vector<float> age(n, 0);
+    std::vector<float> referencePeak(peak);
+    std::vector<float> referenceAge(age);
+    std::vector<float> levels(n, -60);
+    int mismatches = 0;
+    for (int spectrum = 0; spectrum < 3000; spectrum++) {
+        for (float& value : levels) {
+            value = std::min(0.0f, std::max(-120.0f, value + jump(random)));
+        }
+        simd::peakHold(levels.data(), peak.data(), age.data(), n, elapsed, holdTime, fall);
+        for (int i = 0; i < n; i++) {
+            float heldFor = referenceAge[i] + elapsed;
+            if (levels[i] >= referencePeak[i]) {
+                referencePeak[i] = levels[i];
+                referenceAge[i] = 0;
+            } else {
+                if (heldFor > holdTime) {
+                    referencePeak[i] = std::max(referencePeak[i] - fall, levels[i]);
+                }
+                referenceAge[i] = heldFor;
+            }
+        }
+        if (peak != referencePeak || age != referenceAge) {
+            mismatches++;
+        }
+    }
+    benchmark.check(
+        "simd.peakHold", mismatches == 0,
+        "differs from the reference after " + std::to_string(mismatches) + " of 3000 spectra");
+}
+
+static void benchMagnitudeToDb(Benchmark& benchmark)
+{
+    const int n = 4096;
+    std::mt19937 random(91011);
+    // Components spanning 24 orders of magnitude, as real spectra do.
+    std::uniform_real_distribution<float> exponent(-12, 0);
+    std::uniform_real_distribution<float> sign(-1, 1);
+    std::vector<float> complex(2 * n);
+    std::vector<double> complexDouble(2 * n);
+    for (int i = 0; i < 2 * n; i++) {
+        complex[i] = sign(random) * std::pow(10.0f, exponent(random));
+        complexDouble[i] = complex[i];
+    }
+    std::vector<float> fast(n);
+    std::vector<float> exact(n);
+
+    // The accuracy is checked whatever the filter, against the textbook
+    // formula rather than the double kernel.
+    simd::magnitudeToDb(complex.data(), fast.data(), n);
+    double maximumError = 0;
+    for (int i = 0; i < n; i++) {
+        double reference = 20 * std::log10(std::hypot(complexDouble[2 * i], complexDouble[2 * i + 1]));
+        maximumError = std::max(maximumError, std::fabs(fast[i] - reference));
+    }
+    benchmark.check(
+        "simd.magnitudeToDb", maximumError <= k_maxMagnitudeErrorDb,
+        "error of " + std::to_string(maximumError) + " dB is over " + std::to_string(k_maxMagnitudeErrorDb));
+
+    benchmark.run("simd.magnitudeToDb", { { "bins", n } }, n, [&] {
+        simd::magnitudeToDb(complex.data(), fast.data(), n);
+    });
+    if (benchmark.isEnabled("simd.magnitudeToDb")) {
+        benchmark.addMetric("max_error_db", maximumError);
+    }
+
+    benchmark.run("simd.magnitudeToDb_exact", { { "bins", n } }, n, [&] {
+        simd::magnitudeToDb(complexDouble.data(), exact.data(), n);
+    });
+}
+
+// Spectrum::update() as it was before chunk ranges and curve bases were
+// precomputed: a chunk lookup and bounds check per bin, and the
+// Catmull-Rom curve and its derivative evaluated per plot point with
+// clamped indices and std::atan2. Kept to measure the speedup against and
+// to check that the output still matches.
+class ReferenceSpectrum {
+public:
+    ReferenceSpectrum(Spectrum& spectrum, const std::vector<float>& binFrequencies, float plotPointPadding)
+        : m_chunkX(spectrum.getChunkX())
+        , m_numChunks(m_chunkX.size())
+        , m_binToChunk(binFrequencies.size(), -1)
+        , m_chunkY(m_numChunks)
+        , m_lastChunkY(m_numChunks, -1000)
+        , m_plotY(m_numChunks * k_cubicResolution)
+        , m_plotNormal(m_numChunks * k_cubicResolution)
+    {
+        int chunk = -1;
+        int lastNominalChunk = 0;
+        for (size_t i = 0; i < binFrequencies.size(); i++) {
+            float position = spectrum.position(binFrequencies[i]);
+            if (position > 1.0) {
+                continue;
+            }
+            int nominalChunk = static_cast<int>(std::floor(position * spectrum.getWindowWidth() / plotPointPadding));
+            if (chunk < 0 || nominalChunk != lastNominalChunk) {
+                chunk++;
+            }
+            m_binToChunk[i] = chunk;
+            lastNominalChunk = nominalChunk;
+        }
+    }
+
+    void update(const float* magnitudes, float kAttack, float kRelease)
+    {
+        std::fill(m_chunkY.begin(), m_chunkY.end(), -1000);
+        for (size_t i = 0; i < m_binToChunk.size(); i++) {
+            int chunk = m_binToChunk[i];
+            if (chunk < 0 || chunk >= m_numChunks) {
+                break;
+            }
+            m_chunkY[chunk] = std::max(m_chunkY[chunk], magnitudes[i]);
+        }
+        for (int i = 0; i < m_numChunks; i++) {
+            float k = m_lastChunkY[i] > m_chunkY[i] ? kRelease : kAttack;
+            m_lastChunkY[i] = m_lastChunkY[i] * k + m_chunkY[i] * (1 - k);
+        }
+
+        for (size_t i = 0; i < m_plotY.size(); i++) {
+            int t1 = i / k_cubicResolution;
+            int t0 = std::max(t1 - 1, 0);
+            int t2 = std::min(t1 + 1, m_numChunks - 1);
+            int t3 = std::min(t1 + 2, m_numChunks - 1);
+            float t = static_cast<float>(i) / k_cubicResolution - t1;
+            const std::vector<float>& y = m_lastChunkY;
+            const std::vector<float>& x = m_chunkX;
+            m_plotY[i] = cubic(t, y[t0], y[t1], y[t2], y[t3]);
+            m_plotNormal[i] = std::atan2(
+                cubicDerivative(t, y[t0], y[t1], y[t2], y[t3]) / 60,
+                cubicDerivative(t, x[t0], x[t1], x[t2], x[t3]));
+        }
+    }
+
+    const std::vector<float>& getPlotY() { return m_plotY; }
+    const std::vector<float>& getPlotNormal() { return m_plotNormal; }
+
+private:
+    static const int k_cubicResolution = 5;
+
+    const std::vector<float> m_chunkX;
+    const int m_numChunks;
+    std::vector<int> m_binToChunk;
+    std::vector<float> m_chunkY;
+    std::vector<float> m_lastChunkY;
+    std::vector<float> m_plotY;
+    std::vector<float> m_plotNormal;
+
+    static float cubic(float t, float y0, float y1, float y2, float y3)
+    {
+        return ((-y0 + 3 * y1 - 3 * y2 + y3) * t * t * t
+                   + (2 * y0 - 5 * y1 + 4 * y2 - y3) * t * t
+                   + (-y0 + y2) * t
+                   + 2 * y1)
+            * 0.5f;
+    }
+
+    static float cubicDerivative(float t, float y0, float y1, float y2, float y3)
+    {
+        return (3 * (-y0 + 3 * y1 - 3 * y2 + y3) * t * t
+                   + 2 * (2 * y0 - 5 * y1 + 4 * y2 - y3) * t
+                   + (-y0 + y2))
+            * 0.5f;
+    }
+};
+
+// The largest difference between two equally long arrays.
+static double maximumDifference(const std::vector<float>& a, const std::vector<float>& b, int n)
+{
+    double difference = 0;
+    for (int i = 0; i < n; i++) {
+        difference = std::max(difference, static_cast<double>(std::fabs(a[i] - b[i])));
+    }
+    return difference;
+}
+
+static void benchSpectrum(Benchmark& benchmark)
+{
+    for (int fftSize : { 2048, 8192, 32768, 131072, 262144 }) {
+        std::vector<float> binFrequencies = fftBinFrequencies(fftSize);
+        std::vector<std::vector<float>> magnitudes;
+        for (int i = 0; i < 4; i++) {
+            magnitudes.push_back(randomMagnitudes(binFrequencies.size()));
+        }
+        Spectrum spectrum(binFrequencies, 2, 0.1, 1.5);
+        BenchmarkParameters parameters = { { "size", fftSize }, { "width", k_windowWidth } };
+
+        benchmark.run("spectrum.setWindowSize", parameters, binFrequencies.size(), [&] {
+            spectrum.setWindowSize(k_windowWidth, k_windowHeight);
+        });
+        spectrum.setWindowSize(k_windowWidth, k_windowHeight);
+
+        int frame = 0;
+        benchmark.run("spectrum.update", parameters, binFrequencies.size(), [&] {
+            spectrum.update(magnitudes[frame++ % magnitudes.size()].data());
+        });
+        benchmark.addMetric("plot_points", spectrum.getNumPlotPoints());
+        benchmark.run("spectrum.updateChunks", parameters, binFrequencies.size(), [&] {
+            spectrum.updateChunks(magnitudes[frame++ % magnitudes.size()].data());
+        });
+
+        // The same spectra through both, from the same starting levels.
+        Spectrum checked(binFrequencies, 2, 0.1, 1.5);
+        checked.setWindowSize(k_windowWidth, k_windowHeight);
+        ReferenceSpectrum reference(checked, binFrequencies, 2);
+        float kAttack = 1 - std::exp(-0.1f);
+        float kRelease = 1 - std::exp(-1.5f);
+        for (size_t i = 0; i < magnitudes.size(); i++) {
+            checked.update(magnitudes[i].data());
+            reference.update(magnitudes[i].data(), kAttack, kRelease);
+        }
+        int numPoints = checked.getNumPlotPoints();
+        double levelError = maximumDifference(checked.getPlotY(), reference.getPlotY(), numPoints);
+        double angleError = maximumDifference(checked.getPlotNormal(), reference.getPlotNormal(), numPoints);
+        benchmark.check(
+            "spectrum.update", levelError <= k_maxSpectrumLevelError && angleError <= k_maxSpectrumAngleError,
+            "differs from the reference by " + std::to_string(levelError) + " dB and "
+                + std::to_string(angleError) + " rad at size " + std::to_string(fftSize));
+
+        benchmark.run("spectrum.update_reference", parameters, binFrequencies.size(), [&] {
+            reference.update(magnitudes[frame++ % magnitudes.size()].data(), kAttack, kRelease);
+        });
+    }
+}
+
+static void benchCurveGeometry(Benchmark& benchmark)
+{
+    const int fftSize = 32768;
+    Spectrum spectrum(fftBinFrequencies(fftSize), 2, 0.1, 1.5);
+    spectrum.setWindowSize(k_windowWidth, k_windowHeight);
+    std::vector<float> magnitudes = randomMagnitudes(spectrum.getSpectrumSize());
+    for (int i = 0; i < 10; i++) {
+        spectrum.update(magnitudes.data());
+    }
+    RangeComputer rangeComputer;
+    std::vector<CurveVertex> vertices(2 * spectrum.getNumPlotPoints());
+    std::array<float, 4> color = { { 1, 0.8f, 0.4f, 0.8f } };
+    BenchmarkParameters parameters = { { "points", spectrum.getNumPlotPoints() } };
+
+    benchmark.run("curve.stroke", parameters, spectrum.getNumPlotPoints(), [&] {
+        strokeCurve(spectrum, rangeComputer, color, 8, k_windowWidth, k_windowHeight, vertices.data());
+    });
+    benchmark.run("curve.fill", parameters, spectrum.getNumPlotPoints(), [&] {
+        fillCurve(spectrum, rangeComputer, color, vertices.data());
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string outputPath;
+    std::string filter;
+    double minimumSeconds = 0.2;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--output") {
+            outputPath = argv[++i];
+        } else if (arg == "--filter") {
+            filter = argv[++i];
+        } else if (arg == "--min-time") {
+            minimumSeconds = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Unrecognized argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    Benchmark benchmark(filter, minimumSeconds);
+    benchIngress(benchmark);
+    benchFFT(benchmark);
+    benchSlidingDFT(benchmark);
+    benchEngines(benchmark);
+    benchSpectralMaximum(benchmark);
+    benchAccumulators(benchmark);
+    checkAccumulatorKernels(benchmark);
+    benchMagnitudeToDb(benchmark);
+    benchSpectrum(benchmark);
+    benchCurveGeometry(benchmark);
+
+    benchmark.printSummary(std::cerr);
+    if (outputPath.empty()) {
+        benchmark.writeJSON(std::cout);
+    } else {
+        std::ofstream output(outputPath);
+        if (!output) {
+            std::cerr << "Could not open " << outputPath << std::endl;
+            return 1;
+        }
+        benchmark.writeJSON(output);
+    }
+    return benchmark.hasFailures() ? 1 : 0;
+}
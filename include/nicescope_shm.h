@@ -0,0 +1,217 @@
+/*
+ * Reader side of NiceScope's shared-memory spectrum feed (--shm <name>).
+ *
+ * The producer keeps a POSIX shared-memory object laid out as a header, the
+ * bin frequencies, then a ring of num_slots slots. Analysis frame number n
+ * (counting from 1) goes into slot n % num_slots. Every slot has a seqlock:
+ * lock is odd while the producer writes the slot, and goes up by 2 with
+ * every write. The producer never waits for readers. A reader that is too
+ * slow sees the lock change and retries, or finds the frame overwritten and
+ * skips ahead.
+ *
+ * To read in place, without copying:
+ *
+ *     uint64_t n = nicescope_shm_latest(header);
+ *     const nicescope_shm_slot* slot = nicescope_shm_slot_at(header, n);
+ *     uint64_t lock;
+ *     if (!nicescope_shm_begin_read(slot, &lock)) {
+ *         if (!nicescope_shm_producer_alive(header)) {
+ *             ... the producer died while writing: detach ...
+ *         }
+ *         ... it is still writing: try again later ...
+ *     }
+ *     ... use slot fields and nicescope_shm_magnitudes(header, slot, channel) ...
+ *     if (!nicescope_shm_end_read(slot, lock) || slot->sequence != n) {
+ *         ... the frame changed while it was read: discard and retry ...
+ *     }
+ *
+ * Anything computed from the slot before end_read() succeeds must be thrown
+ * away if it fails. A producer killed in the middle of a write leaves that
+ * slot locked for good, which is why begin_read() gives up after a while
+ * rather than waiting forever. Times are seconds. Monotonic times are on
+ * CLOCK_MONOTONIC, so they can be compared with the reader's own clock.
+ *
+ * C99 plus the GCC/Clang __atomic builtins and POSIX. Every field is
+ * naturally aligned, and the producer and reader must share the same
+ * endianness, which they do on one machine.
+ */
+#ifndef NICESCOPE_SHM_H
+#define NICESCOPE_SHM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NICESCOPE_SHM_MAGIC 0x5053434eu /* "NCSP" */
+#define NICESCOPE_SHM_VERSION 1u
+/* How many times nicescope_shm_begin_read() looks at a locked slot. */
+#define NICESCOPE_SHM_SPIN_LIMIT (1u << 20)
+
+typedef struct {
+    /* Written last when the producer creates the object, so a reader that
+     * sees the magic number sees a complete header. */
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t num_slots;
+    /* Byte offsets from the start of the object. */
+    uint64_t bin_frequencies_offset;
+    uint64_t slots_offset;
+    uint64_t slot_size;
+    uint64_t total_size;
+    uint32_t num_channels;
+    uint32_t spectrum_size;
+    /* Most chunks a slot can hold. */
+    uint32_t max_chunks;
+    float sample_rate;
+    int32_t producer_pid;
+    uint32_t reserved;
+    /* Number of the newest complete frame, 0 before the first. */
+    uint64_t latest_sequence;
+} nicescope_shm_header;
+
+typedef struct {
+    uint64_t lock;
+    /* Frame number, from 1. */
+    uint64_t sequence;
+    /* Monotonic time at which the newest sample in the frame was captured,
+     * and at which the frame was published. */
+    double adc_time;
+    double publish_time;
+    /* Wall-clock time of publishing, since the Unix epoch. */
+    double wall_time;
+    /* Highest level in the frame, in dB. */
+    float maximum;
+    /* Chunks of the maximum spectrum over all channels, as the display
+     * draws them for a 1024 pixel wide plot: positions from 0 (lowest
+     * frequency shown) to 1 (highest), and the highest level in dB among
+     * the bins of each chunk. */
+    uint32_t num_chunks;
+    /* Followed at 64-byte aligned offsets from the slot's start by:
+     *     float magnitudes[num_channels][spectrum_size];  in dB
+     *     float chunk_x[max_chunks];
+     *     float chunk_y[max_chunks];  */
+} nicescope_shm_slot;
+
+#define NICESCOPE_SHM_ALIGN(size) (((size) + 63) & ~(uint64_t)63)
+
+static inline uint64_t nicescope_shm_magnitudes_offset(void)
+{
+    return NICESCOPE_SHM_ALIGN(sizeof(nicescope_shm_slot));
+}
+
+static inline uint64_t nicescope_shm_chunks_offset(const nicescope_shm_header* header)
+{
+    return nicescope_shm_magnitudes_offset()
+        + NICESCOPE_SHM_ALIGN((uint64_t)header->num_channels * header->spectrum_size * sizeof(float));
+}
+
+static inline const float* nicescope_shm_bin_frequencies(const nicescope_shm_header* header)
+{
+    return (const float*)((const char*)header + header->bin_frequencies_offset);
+}
+
+static inline uint64_t nicescope_shm_latest(const nicescope_shm_header* header)
+{
+    return __atomic_load_n(&header->latest_sequence, __ATOMIC_ACQUIRE);
+}
+
+static inline const nicescope_shm_slot* nicescope_shm_slot_at(const nicescope_shm_header* header, uint64_t sequence)
+{
+    const char* slots = (const char*)header + header->slots_offset;
+    return (const nicescope_shm_slot*)(slots + (sequence % header->num_slots) * header->slot_size);
+}
+
+static inline const float* nicescope_shm_magnitudes(
+    const nicescope_shm_header* header, const nicescope_shm_slot* slot, int channel)
+{
+    const float* magnitudes = (const float*)((const char*)slot + nicescope_shm_magnitudes_offset());
+    return magnitudes + (uint64_t)channel * header->spectrum_size;
+}
+
+static inline const float* nicescope_shm_chunk_x(const nicescope_shm_header* header, const nicescope_shm_slot* slot)
+{
+    return (const float*)((const char*)slot + nicescope_shm_chunks_offset(header));
+}
+
+static inline const float* nicescope_shm_chunk_y(const nicescope_shm_header* header, const nicescope_shm_slot* slot)
+{
+    return nicescope_shm_chunk_x(header, slot) + header->max_chunks;
+}
+
+/* Waits out a write in progress and stores the lock value to hand to
+ * nicescope_shm_end_read() in *lock. Returns 0 if the slot was still being
+ * written after NICESCOPE_SHM_SPIN_LIMIT tries, which takes far longer
+ * than a write unless the producer was descheduled or died in the middle
+ * of it. */
+static inline int nicescope_shm_begin_read(const nicescope_shm_slot* slot, uint64_t* lock)
+{
+    for (uint32_t i = 0; i < NICESCOPE_SHM_SPIN_LIMIT; i++) {
+        *lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+        if (!(*lock & 1)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Nonzero if the slot did not change since nicescope_shm_begin_read(). */
+static inline int nicescope_shm_end_read(const nicescope_shm_slot* slot, uint64_t lock)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->lock, __ATOMIC_RELAXED) == lock;
+}
+
+/* Nonzero if the process that created the object still runs. A producer
+ * that went away leaves its object behind, and the next one replaces it
+ * with a new object, so a reader of a dead producer has to attach again. */
+static inline int nicescope_shm_producer_alive(const nicescope_shm_header* header)
+{
+    /* EPERM means the process exists but belongs to someone else. */
+    return kill((pid_t)header->producer_pid, 0) == 0 || errno != ESRCH;
+}
+
+/* Maps the object read-only. Returns NULL if it does not exist or is not a
+ * feed this header can read; *size receives its size for munmap(). */
+static inline const nicescope_shm_header* nicescope_shm_attach(const char* name, size_t* size)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(nicescope_shm_header)) {
+        close(fd);
+        return NULL;
+    }
+    void* memory = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+    const nicescope_shm_header* header = (const nicescope_shm_header*)memory;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != NICESCOPE_SHM_MAGIC
+        || header->version != NICESCOPE_SHM_VERSION
+        || header->header_size != sizeof(nicescope_shm_header)
+        || header->total_size > (uint64_t)status.st_size) {
+        munmap(memory, (size_t)status.st_size);
+        return NULL;
+    }
+    *size = (size_t)status.st_size;
+    return header;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "FFT.hpp"
+
+// A way of turning Ingress history into magnitude spectra. The Analyzer
+// reads getHopSize() frames at a time and calls process() after each read;
+// whenever that returns true, getMagnitudes() holds a new [channel][bin]
+// matrix in dB whose bins lie at getBinFrequencies().
+//
+// A read can come back short, or skip frames the audio callback overwrote
+// after an overrun, so process() is told how many frames the read actually
+// added to the history and how many were dropped before them.
+class AnalysisEngine {
+public:
+    virtual ~AnalysisEngine() { }
+
+    virtual int getHopSize() = 0;
+    // Longest stretch of Ingress history process() reads.
+    virtual int getLongestWindow() = 0;
+    virtual int getNumChannels() = 0;
+    virtual const std::vector<float>& getBinFrequencies() = 0;
+
+    // The frequency range worth displaying.
+    virtual float getLowestFrequency() { return 50; }
+    virtual float getHighestFrequency() { return 20e3; }
+
+    // Whether a fresh engine started on a stream at any multiple of
+    // ceil(getLongestWindow() / getHopSize()) hops gives the same spectra as
+    // one that ran from the start, once it has seen a longest window. That
+    // holds when process() depends only on that much history and on where
+    // the hop falls in a cycle that divides that multiple. Offline analysis
+    // only splits a file across threads for engines that can.
+    virtual bool canStartMidStream() { return true; }
+
+    virtual bool process(Ingress& ingress, int frameCount, uint64_t droppedFrames) = 0;
+    virtual const std::vector<float>& getMagnitudes() = 0;
+
+    int getSpectrumSize() { return getBinFrequencies().size(); }
+};
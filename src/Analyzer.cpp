@@ -0,0 +1,119 @@
+#include "Analyzer.hpp"
+#include "SharedMemoryPublisher.hpp"
+
+FrameBuilder::FrameBuilder(int numChannels, int spectrumSize, const AccumulatorSettings& accumulatorSettings)
+    : m_numChannels(numChannels)
+    , m_spectrumSize(spectrumSize)
+    , m_spectralMaximum(spectrumSize)
+    , m_accumulators(spectrumSize, accumulatorSettings)
+{
+}
+
+AnalysisFrame FrameBuilder::makeEmptyFrame()
+{
+    AnalysisFrame frame;
+    frame.magnitudes.resize(m_numChannels * m_spectrumSize, -1000);
+    frame.spectrumSize = m_spectrumSize;
+    frame.maximumSpectrum.resize(m_spectrumSize, -1000);
+    frame.traces.resize(m_accumulators.getNumTraces() * m_spectrumSize, -1000);
+    return frame;
+}
+
+void FrameBuilder::build(const float* magnitudes, float elapsed, AnalysisFrame& frame)
+{
+    std::copy(magnitudes, magnitudes + m_numChannels * m_spectrumSize, frame.magnitudes.begin());
+
+    m_spectralMaximum.process(magnitudes, m_numChannels);
+    const std::vector<float>& maximumSpectrum = m_spectralMaximum.getMagnitudeSpectrum();
+    std::copy(maximumSpectrum.begin(), maximumSpectrum.end(), frame.maximumSpectrum.begin());
+    frame.maximum = m_spectralMaximum.getMaximum();
+
+    m_accumulators.process(maximumSpectrum.data(), elapsed);
+    const std::vector<float>& traces = m_accumulators.getTraces();
+    std::copy(traces.begin(), traces.end(), frame.traces.begin());
+}
+
+Analyzer::Analyzer(
+    Ingress& ingress,
+    std::unique_ptr<AnalysisEngine> engine,
+    float sampleRate,
+    const AccumulatorSettings& accumulatorSettings)
+    : m_ingress(ingress)
+    , m_engine(std::move(engine))
+    , m_sampleRate(sampleRate)
+    , m_hopSize(m_engine->getHopSize())
+    // Poll a few times per hop so a finished hop waits at most a fraction of
+    // its own duration.
+    , m_pollInterval(static_cast<int>(1e6 * m_hopSize / sampleRate / 4))
+    , m_frameBuilder(ingress.getNumChannels(), m_engine->getSpectrumSize(), accumulatorSettings)
+    , m_resetRequested(false)
+    , m_frames(m_frameBuilder.makeEmptyFrame())
+    , m_running(false)
+{
+    if (std::max(m_engine->getLongestWindow(), m_hopSize) > ingress.getHistorySize()) {
+        throw std::runtime_error("Ingress history is shorter than the longest analysis window.");
+    }
+}
+
+Analyzer::~Analyzer()
+{
+    stop();
+}
+
+void Analyzer::start()
+{
+    m_running = true;
+    m_thread = std::thread(&Analyzer::run, this);
+}
+
+void Analyzer::stop()
+{
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void Analyzer::run()
+{
+    while (m_running) {
+        if (m_ingress.getReadAvailable() < m_hopSize) {
+            std::this_thread::sleep_for(m_pollInterval);
+            continue;
+        }
+        int frameCount = m_ingress.bufferSamples(m_hopSize);
+        m_framesSinceAnalysis += frameCount;
+        for (SPSCRing* tap : m_taps) {
+            tap->write(m_ingress.getBufferedFrames(), frameCount);
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (m_engine->process(m_ingress, frameCount, m_ingress.getLastDroppedFrames())) {
+            analyze(start);
+        }
+    }
+}
+
+// start is when the engine began on the hop that finished this frame.
+void Analyzer::analyze(std::chrono::steady_clock::time_point start)
+{
+    AnalysisFrame& frame = m_frames.getWriteBuffer();
+
+    if (m_resetRequested.exchange(false)) {
+        m_frameBuilder.resetAccumulators();
+    }
+    m_frameBuilder.build(m_engine->getMagnitudes().data(), m_framesSinceAnalysis / m_sampleRate, frame);
+    m_framesSinceAnalysis = 0;
+
+    frame.ingressStats = m_ingress.getStats();
+
+    IngressTimestamp timestamp = m_ingress.getLatestTimestamp();
+    double framesAfterTimestamp = static_cast<double>(m_ingress.getReadFrames() - 1)
+        - static_cast<double>(timestamp.frame);
+    frame.newestSampleTime = timestamp.adcTime + framesAfterTimestamp / m_sampleRate;
+    frame.analysisSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (m_publisher) {
+        m_publisher->publish(frame);
+    }
+    m_frames.publish();
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AnalysisEngine.hpp"
+#include "FFT.hpp"
+#include "SPSCRing.hpp"
+#include "SpectrumAccumulators.hpp"
+#include "TripleBuffer.hpp"
+
+class SharedMemoryPublisher;
+
+struct AnalysisFrame {
+    // [channel][bin] magnitudes in dB.
+    std::vector<float> magnitudes;
+    int spectrumSize = 0;
+    std::vector<float> maximumSpectrum;
+    float maximum = -1000;
+    // [trace][bin] accumulator traces of the maximum spectrum, in dB.
+    std::vector<float> traces;
+    IngressStats ingressStats;
+    // When the newest sample that went into this frame was captured, on the
+    // clock of getSteadyTime(), and how long the analysis took.
+    double newestSampleTime = 0;
+    double analysisSeconds = 0;
+
+    const float* getMagnitudeSpectrum(int channel) const { return &magnitudes[channel * spectrumSize]; }
+    const float* getTrace(int trace) const { return &traces[trace * spectrumSize]; }
+};
+
+// What becomes of an engine's spectra before they are shown: the maximum
+// over channels, and the accumulators that follow it, written into an
+// AnalysisFrame with the spectra themselves.
+class FrameBuilder {
+public:
+    FrameBuilder(int numChannels, int spectrumSize, const AccumulatorSettings& accumulatorSettings);
+
+    const std::vector<AccumulatorKind>& getAccumulatorKinds() { return m_accumulators.getKinds(); }
+    // A frame of the right sizes with every level at -1000 dB.
+    AnalysisFrame makeEmptyFrame();
+    void resetAccumulators() { m_accumulators.reset(); }
+
+    // magnitudes is [channel][bin] in dB, which arrived elapsed seconds of
+    // audio after the previous spectrum.
+    void build(const float* magnitudes, float elapsed, AnalysisFrame& frame);
+
+private:
+    const int m_numChannels;
+    const int m_spectrumSize;
+    SpectralMaximum m_spectralMaximum;
+    SpectrumAccumulators m_accumulators;
+};
+
+// Runs an AnalysisEngine on its own thread. Every hop of new frames from
+// the Ingress is handed to the engine, and the spectra it finishes are
+// passed to the render thread through a triple buffer, so neither side can
+// stall the other. The maximum spectrum also feeds the accumulators, whose
+// traces go out with every frame.
+class Analyzer {
+public:
+    Analyzer(
+        Ingress& ingress,
+        std::unique_ptr<AnalysisEngine> engine,
+        float sampleRate,
+        const AccumulatorSettings& accumulatorSettings = AccumulatorSettings());
+    ~Analyzer();
+
+    Analyzer(const Analyzer& other) = delete;
+    Analyzer& operator=(const Analyzer& other) = delete;
+
+    AnalysisEngine& getEngine() { return *m_engine; }
+    int getSpectrumSize() { return m_engine->getSpectrumSize(); }
+    const std::vector<float>& getBinFrequencies() { return m_engine->getBinFrequencies(); }
+    int getHopSize() { return m_hopSize; }
+    const std::vector<AccumulatorKind>& getAccumulatorKinds() { return m_frameBuilder.getAccumulatorKinds(); }
+
+    // Passes on every frame read from the Ingress, interleaved, to a
+    // consumer on another thread. The ring must have as many channels as
+    // the Ingress and outlive the Analyzer. Call before start().
+    void addTap(SPSCRing& ring) { m_taps.push_back(&ring); }
+    // Also writes every frame to shared memory. The publisher must outlive
+    // the Analyzer. Call before start().
+    void setPublisher(SharedMemoryPublisher& publisher) { m_publisher = &publisher; }
+
+    void start();
+    void stop();
+
+    // Render thread. Returns true if a new frame arrived since the last call.
+    bool update() { return m_frames.update(); }
+    const AnalysisFrame& getFrame() { return m_frames.getReadBuffer(); }
+    // Any thread. Starts the accumulators over before the next frame.
+    void resetAccumulators() { m_resetRequested = true; }
+
+private:
+    Ingress& m_ingress;
+    std::unique_ptr<AnalysisEngine> m_engine;
+    const float m_sampleRate;
+    const int m_hopSize;
+    const std::chrono::microseconds m_pollInterval;
+
+    FrameBuilder m_frameBuilder;
+    std::atomic<bool> m_resetRequested;
+    // Frames read from the Ingress since the last analyzed frame.
+    int m_framesSinceAnalysis = 0;
+    TripleBuffer<AnalysisFrame> m_frames;
+    std::vector<SPSCRing*> m_taps;
+    SharedMemoryPublisher* m_publisher = nullptr;
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    void run();
+    void analyze(std::chrono::steady_clock::time_point start);
+};
@@ -0,0 +1,199 @@
+#include "AudioFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SampleFormat parseSampleFormat(const std::string& format)
+{
+    if (format == "s16") {
+        return SampleFormat::Int16;
+    } else if (format == "s24") {
+        return SampleFormat::Int24;
+    } else if (format == "s32") {
+        return SampleFormat::Int32;
+    } else if (format == "f32") {
+        return SampleFormat::Float32;
+    }
+    throw std::runtime_error("Sample format must be s16, s24, s32 or f32");
+}
+
+static int bytesPerSample(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::Int16:
+        return 2;
+    case SampleFormat::Int24:
+        return 3;
+    case SampleFormat::Int32:
+    case SampleFormat::Float32:
+        return 4;
+    }
+    return 2;
+}
+
+// Little-endian fields, whatever the byte order of the machine.
+static uint32_t readUint16(const unsigned char* bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static uint32_t readUint32(const unsigned char* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+AudioFile::AudioFile(const std::string& path)
+    : m_path(path)
+{
+    map();
+    try {
+        parseWAV();
+    } catch (...) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+        throw;
+    }
+}
+
+AudioFile::AudioFile(const std::string& path, int numChannels, float sampleRate, SampleFormat format)
+    : m_path(path)
+    , m_numChannels(numChannels)
+    , m_sampleRate(sampleRate)
+    , m_format(format)
+    , m_bytesPerSample(bytesPerSample(format))
+{
+    if (numChannels < 1 || sampleRate <= 0) {
+        throw std::runtime_error("Raw audio needs a channel count and a positive sample rate");
+    }
+    map();
+    setSampleData(m_data, m_size);
+}
+
+AudioFile::~AudioFile()
+{
+    if (m_data) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+}
+
+void AudioFile::map()
+{
+    int fd = open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + m_path);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Could not read " + m_path);
+    }
+    m_size = status.st_size;
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + m_path);
+    }
+    // Each reader goes through its part of the file front to back.
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(data);
+}
+
+void AudioFile::parseWAV()
+{
+    if (m_size < 12 || std::memcmp(m_data, "RIFF", 4) != 0 || std::memcmp(m_data + 8, "WAVE", 4) != 0) {
+        throw std::runtime_error(m_path + " is not a WAV file");
+    }
+
+    bool haveFormat = false;
+    size_t position = 12;
+    while (position + 8 <= m_size) {
+        const unsigned char* chunk = m_data + position;
+        size_t chunkSize = readUint32(chunk + 4);
+        size_t available = m_size - position - 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || chunkSize > available) {
+                throw std::runtime_error(m_path + " has a broken format chunk");
+            }
+            uint32_t formatTag = readUint16(chunk + 8);
+            m_numChannels = readUint16(chunk + 10);
+            m_sampleRate = readUint32(chunk + 12);
+            uint32_t bitsPerSample = readUint16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start
+            // of its subformat GUID.
+            if (formatTag == 0xfffe && chunkSize >= 40) {
+                formatTag = readUint16(chunk + 32);
+            }
+            if (formatTag == 1 && bitsPerSample == 16) {
+                m_format = SampleFormat::Int16;
+            } else if (formatTag == 1 && bitsPerSample == 24) {
+                m_format = SampleFormat::Int24;
+            } else if (formatTag == 1 && bitsPerSample == 32) {
+                m_format = SampleFormat::Int32;
+            } else if (formatTag == 3 && bitsPerSample == 32) {
+                m_format = SampleFormat::Float32;
+            } else {
+                throw std::runtime_error(m_path + " is not 16, 24 or 32-bit integer or 32-bit float PCM");
+            }
+            m_bytesPerSample = bytesPerSample(m_format);
+            if (m_numChannels < 1 || m_sampleRate <= 0) {
+                throw std::runtime_error(m_path + " has no channels or no sample rate");
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                throw std::runtime_error(m_path + " has its data before its format");
+            }
+            // Recorders that were cut off leave the size unset or too big,
+            // so take whatever is there.
+            setSampleData(chunk + 8, std::min(chunkSize, available));
+            return;
+        }
+        // Chunks are padded to an even size.
+        position += 8 + chunkSize + (chunkSize & 1);
+    }
+    throw std::runtime_error(m_path + " has no audio data");
+}
+
+void AudioFile::setSampleData(const unsigned char* samples, size_t size)
+{
+    m_samples = samples;
+    m_numFrames = size / (m_numChannels * m_bytesPerSample);
+}
+
+void AudioFile::read(uint64_t start, int numFrames, float* interleaved) const
+{
+    int available = start < m_numFrames ? static_cast<int>(std::min<uint64_t>(numFrames, m_numFrames - start)) : 0;
+    int numSamples = available * m_numChannels;
+    const unsigned char* bytes = m_samples + start * m_numChannels * m_bytesPerSample;
+
+    switch (m_format) {
+    case SampleFormat::Int16:
+        for (int i = 0; i < numSamples; i++, bytes += 2) {
+            interleaved[i] = static_cast<int16_t>(readUint16(bytes)) * (1.0f / 32768);
+        }
+        break;
+    case SampleFormat::Int24:
+        for (int i = 0; i < numSamples; i++, bytes += 3) {
+            // Shifted to the top of 32 bits to sign-extend it.
+            int32_t sample = static_cast<int32_t>((bytes[0] << 8) | (bytes[1] << 16) | (static_cast<uint32_t>(bytes[2]) << 24));
+            interleaved[i] = sample * (1.0f / 2147483648.0f);
+        }
+        break;
+    case SampleFormat::Int32:
+        for (int i = 0; i < numSamples; i++, bytes += 4) {
+            interleaved[i] = static_cast<int32_t>(readUint32(bytes)) * (1.0f / 2147483648.0f);
+        }
+        break;
+    case SampleFormat::Float32:
+        for (int i = 0; i < numSamples; i++, bytes += 4) {
+            uint32_t bits = readUint32(bytes);
+            std::memcpy(&interleaved[i], &bits, sizeof(float));
+        }
+        break;
+    }
+    std::fill(interleaved + numSamples, interleaved + numFrames * m_numChannels, 0.0f);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+enum class SampleFormat {
+    Int16,
+    Int24,
+    Int32,
+    Float32,
+};
+
+// Parses "s16", "s24", "s32" or "f32".
+SampleFormat parseSampleFormat(const std::string& format);
+
+// A recording mapped into memory, read-only. Samples are converted to float
+// as they are read, straight from the mapping, so a file of any length costs
+// no memory beyond the pages being read, and any number of threads can read
+// it at once.
+class AudioFile {
+public:
+    // A WAV file: 16, 24 or 32-bit integer or 32-bit float PCM, including
+    // WAVE_FORMAT_EXTENSIBLE.
+    AudioFile(const std::string& path);
+    // Headerless interleaved little-endian PCM.
+    AudioFile(const std::string& path, int numChannels, float sampleRate, SampleFormat format);
+    ~AudioFile();
+
+    AudioFile(const AudioFile& other) = delete;
+    AudioFile& operator=(const AudioFile& other) = delete;
+
+    int getNumChannels() const { return m_numChannels; }
+    float getSampleRate() const { return m_sampleRate; }
+    uint64_t getNumFrames() const { return m_numFrames; }
+
+    // Converts frames [start, start + numFrames) to interleaved floats in
+    // [-1, 1]. Frames past the end read as silence. Any thread.
+    void read(uint64_t start, int numFrames, float* interleaved) const;
+
+private:
+    const std::string m_path;
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    // Where the samples start and how many frames there are.
+    const unsigned char* m_samples = nullptr;
+    uint64_t m_numFrames = 0;
+    int m_numChannels = 0;
+    float m_sampleRate = 0;
+    SampleFormat m_format = SampleFormat::Int16;
+    int m_bytesPerSample = 2;
+
+    void map();
+    void parseWAV();
+    void setSampleData(const unsigned char* samples, size_t size);
+};
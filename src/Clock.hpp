@@ -0,0 +1,10 @@
+#pragma once
+#include <chrono>
+
+// Seconds on std::chrono::steady_clock. Every timestamp that crosses
+// threads, from the audio callback's ADC times to buffer swaps, is on this
+// clock, so any two can be subtracted.
+inline double getSteadyTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
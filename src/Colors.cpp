@@ -0,0 +1,31 @@
+#include "Colors.hpp"
+
+std::array<float, 4> colorFromHex(int string, float alpha)
+{
+    return { { (string >> (4 * 4) & 0xff) / 255.0f,
+        (string >> (2 * 4) & 0xff) / 255.0f,
+        (string & 0xff) / 255.0f,
+        alpha } };
+}
+
+std::array<float, 4> colorFromHex(int string)
+{
+    return colorFromHex(string, 1.0f);
+}
+
+const int k_backgroundColor = 0x1d1f21;
+
+static const std::array<int, 7> k_channelColors = { {
+    0xf0c674,
+    0x8abeb7,
+    0xcc6666,
+    0xb5bd68,
+    0x81a2be,
+    0xb294bb,
+    0xde935f,
+} };
+
+std::array<float, 4> channelColor(int channel, float alpha)
+{
+    return colorFromHex(k_channelColors[channel % k_channelColors.size()], alpha);
+}
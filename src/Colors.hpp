@@ -0,0 +1,10 @@
+#pragma once
+#include <array>
+
+std::array<float, 4> colorFromHex(int string, float alpha);
+std::array<float, 4> colorFromHex(int string);
+
+extern const int k_backgroundColor;
+
+// One color per input channel, cycling when there are more channels.
+std::array<float, 4> channelColor(int channel, float alpha);
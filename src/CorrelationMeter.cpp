@@ -0,0 +1,37 @@
+#include "CorrelationMeter.hpp"
+
+#include <cmath>
+
+CorrelationMeter::CorrelationMeter(float sampleRate, float timeConstantSeconds)
+    : m_framesPerTimeConstant(sampleRate * timeConstantSeconds)
+{
+}
+
+void CorrelationMeter::process(const float* interleaved, int numChannels, int numFrames)
+{
+    float product = 0;
+    float leftEnergy = 0;
+    float rightEnergy = 0;
+    for (int i = 0; i < numFrames; i++) {
+        float left = interleaved[i * numChannels];
+        float right = interleaved[i * numChannels + 1];
+        product += left * right;
+        leftEnergy += left * left;
+        rightEnergy += right * right;
+    }
+
+    double decay = std::exp(-numFrames / m_framesPerTimeConstant);
+    m_product = m_product * decay + product;
+    m_leftEnergy = m_leftEnergy * decay + leftEnergy;
+    m_rightEnergy = m_rightEnergy * decay + rightEnergy;
+}
+
+float CorrelationMeter::getCorrelation()
+{
+    double energy = std::sqrt(m_leftEnergy * m_rightEnergy);
+    // Silence, or close enough that the ratio would be noise.
+    if (energy < 1e-12) {
+        return 0;
+    }
+    return m_product / energy;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Running correlation coefficient between the first two channels of
+// interleaved audio: +1 for mono, 0 for unrelated channels, -1 for one
+// channel the inverse of the other. The sums of L*R, L*L and R*R are kept
+// with exponential forgetting. Every block adds its own sums once, after
+// decaying the running ones by the block's length, so nothing is ever
+// recomputed over the window.
+class CorrelationMeter {
+public:
+    CorrelationMeter(float sampleRate, float timeConstantSeconds);
+
+    void process(const float* interleaved, int numChannels, int numFrames);
+    float getCorrelation();
+
+private:
+    const double m_framesPerTimeConstant;
+    double m_product = 0;
+    double m_leftEnergy = 0;
+    double m_rightEnergy = 0;
+};
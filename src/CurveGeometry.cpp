@@ -0,0 +1,65 @@
+#include "CurveGeometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static void packColor(const std::array<float, 4>& color, uint8_t* packed)
+{
+    for (int i = 0; i < 4; i++) {
+        packed[i] = static_cast<uint8_t>(std::round(std::min(std::max(color[i], 0.0f), 1.0f) * 255));
+    }
+}
+
+void strokeCurve(
+    Spectrum& spectrum,
+    RangeComputer& rangeComputer,
+    const std::array<float, 4>& color,
+    float thicknessInPixels,
+    int windowWidth,
+    int windowHeight,
+    CurveVertex* vertices)
+{
+    const std::vector<float>& plotX = spectrum.getPlotX();
+    const std::vector<float>& plotY = spectrum.getPlotY();
+    const std::vector<float>& plotNormal = spectrum.getPlotNormal();
+    uint8_t packed[4];
+    packColor(color, packed);
+
+    for (int i = 0; i < spectrum.getNumPlotPoints(); i++) {
+        float x = 2 * plotX[i] - 1;
+        float y = rangeComputer.convertValueToScreenY(plotY[i]);
+        float thicknessX = std::sin(plotNormal[i]) * thicknessInPixels / windowWidth * 0.5;
+        float thicknessY = std::cos(plotNormal[i]) * thicknessInPixels / windowHeight * 0.5;
+        CurveVertex& upper = vertices[2 * i];
+        CurveVertex& lower = vertices[2 * i + 1];
+        upper.x = x - thicknessX;
+        upper.y = y + thicknessY;
+        lower.x = x + thicknessX;
+        lower.y = y - thicknessY;
+        std::copy(packed, packed + 4, upper.color);
+        std::copy(packed, packed + 4, lower.color);
+    }
+}
+
+void fillCurve(
+    Spectrum& spectrum,
+    RangeComputer& rangeComputer,
+    const std::array<float, 4>& color,
+    CurveVertex* vertices)
+{
+    const std::vector<float>& plotX = spectrum.getPlotX();
+    const std::vector<float>& plotY = spectrum.getPlotY();
+    uint8_t packed[4];
+    packColor(color, packed);
+
+    for (int i = 0; i < spectrum.getNumPlotPoints(); i++) {
+        CurveVertex& upper = vertices[2 * i];
+        CurveVertex& lower = vertices[2 * i + 1];
+        upper.x = 2 * plotX[i] - 1;
+        upper.y = rangeComputer.convertValueToScreenY(plotY[i]);
+        lower.x = upper.x;
+        lower.y = -1;
+        std::copy(packed, packed + 4, upper.color);
+        std::copy(packed, packed + 4, lower.color);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "FFT.hpp"
+#include "Spectrum.hpp"
+
+// A vertex as ScopeRenderer uploads it: a position in clip space and an
+// RGBA color packed into four normalized bytes.
+struct CurveVertex {
+    float x;
+    float y;
+    uint8_t color[4];
+};
+
+// Write two vertices per plot point of the spectrum, for drawing as a
+// triangle strip (or as indexed triangles pairing consecutive points).
+// strokeCurve() extrudes the curve to thicknessInPixels either side along
+// its normal; fillCurve() pairs each point with the bottom of the screen.
+void strokeCurve(
+    Spectrum& spectrum,
+    RangeComputer& rangeComputer,
+    const std::array<float, 4>& color,
+    float thicknessInPixels,
+    int windowWidth,
+    int windowHeight,
+    CurveVertex* vertices);
+void fillCurve(
+    Spectrum& spectrum,
+    RangeComputer& rangeComputer,
+    const std::array<float, 4>& color,
+    CurveVertex* vertices);
@@ -1,66 +1,139 @@
 #include "FFT.hpp"
+#include "Simd.hpp"
 
-Ingress::Ingress(int numChannels, int fftSize)
+#include <chrono>
+
+Ingress::Ingress(int numChannels, int historySize)
     : m_numChannels(numChannels)
-    , m_ringBufferSize(fftSize * m_numChannels)
-    , m_scratchBufferSize(fftSize * m_numChannels)
-    , m_outputBufferSize(fftSize * m_numChannels)
-    , m_ringBuffer(new PaUtilRingBuffer)
-    , m_ringBufferData(new float[m_ringBufferSize * m_numChannels])
-    , m_scratchBuffer(new float[m_scratchBufferSize * m_numChannels])
-    , m_outputBuffer(new float[m_outputBufferSize * m_numChannels])
+    , m_historySize(historySize)
+    // Leave the consumer a full window of slack before the oldest frames
+    // get overwritten.
+    , m_ring(m_numChannels, 2 * historySize)
+    , m_inputOverflows(0)
+    , m_callbacks(0)
+    , m_callbackNanoseconds(0)
+    , m_maxCallbackNanoseconds(0)
+    , m_timestamps(IngressTimestamp())
+    , m_overruns(0)
+    , m_droppedFrames(0)
+    , m_scratchBuffer(new float[m_historySize * m_numChannels]())
+    , m_history(new float[2 * m_historySize * m_numChannels]())
+    , m_destinations(m_numChannels)
+    , m_mirrorDestinations(m_numChannels)
 {
-    ring_buffer_size_t size = PaUtil_InitializeRingBuffer(
-        m_ringBuffer.get(), sizeof(float) * m_numChannels, m_ringBufferSize, m_ringBufferData.get()
-    );
-    if (size < 0) {
-        throw std::runtime_error("Ring buffer initialization failed.");
-    }
+}
+
+void Ingress::process(
+    InputBuffer input_buffer,
+    OutputBuffer output_buffer,
+    int frame_count,
+    PaStreamCallbackFlags status_flags,
+    double adc_time)
+{
+    auto start = std::chrono::steady_clock::now();
 
-    for (int i = 0; i < m_ringBufferSize * m_numChannels; i++) {
-        m_ringBufferData[i] = 0;
+    if (status_flags & paInputOverflow) {
+        m_inputOverflows.fetch_add(1, std::memory_order_relaxed);
     }
-    for (int i = 0; i < m_scratchBufferSize * m_numChannels; i++) {
-        m_scratchBuffer[i] = 0;
+    m_ring.write(input_buffer, frame_count);
+    if (m_trigger) {
+        m_trigger->process(input_buffer, frame_count);
     }
-    for (int i = 0; i < m_outputBufferSize * m_numChannels; i++) {
-        m_outputBuffer[i] = 0;
+
+    IngressTimestamp& timestamp = m_timestamps.getWriteBuffer();
+    timestamp.frame = m_writtenFrames;
+    timestamp.adcTime = adc_time;
+    m_timestamps.publish();
+    m_writtenFrames += frame_count;
+
+    // Only this thread writes these, so plain loads and stores suffice.
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start)
+                               .count();
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_callbackNanoseconds.store(
+        m_callbackNanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > m_maxCallbackNanoseconds.load(std::memory_order_relaxed)) {
+        m_maxCallbackNanoseconds.store(nanoseconds, std::memory_order_relaxed);
     }
 }
 
-void Ingress::process(InputBuffer input_buffer, OutputBuffer output_buffer, int frame_count)
+IngressStats Ingress::getStats()
+{
+    IngressStats stats;
+    stats.overruns = m_overruns.load(std::memory_order_relaxed);
+    stats.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    stats.inputOverflows = m_inputOverflows.load(std::memory_order_relaxed);
+    stats.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    stats.callbackSeconds = 1e-9 * m_callbackNanoseconds.load(std::memory_order_relaxed);
+    stats.maxCallbackSeconds = 1e-9 * m_maxCallbackNanoseconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+IngressTimestamp Ingress::getLatestTimestamp()
+{
+    m_timestamps.update();
+    return m_timestamps.getReadBuffer();
+}
+
+int Ingress::getReadAvailable()
+{
+    return m_ring.getReadAvailable();
+}
+
+int Ingress::bufferSamples(int maxFrames)
 {
-    auto writeAvailable = PaUtil_GetRingBufferWriteAvailable(m_ringBuffer.get());
-    if (frame_count > writeAvailable) {
-        PaUtil_AdvanceRingBufferReadIndex(m_ringBuffer.get(), frame_count);
+    uint64_t droppedFrames;
+    int frameCount = m_ring.read(m_scratchBuffer.get(), std::min(maxFrames, m_historySize), droppedFrames);
+    if (droppedFrames > 0) {
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+        m_droppedFrames.fetch_add(droppedFrames, std::memory_order_relaxed);
     }
-    PaUtil_WriteRingBuffer(m_ringBuffer.get(), input_buffer, frame_count);
+    m_readFrames += droppedFrames + frameCount;
+    m_lastDroppedFrames = droppedFrames;
+
+    int firstPart = std::min(frameCount, m_historySize - m_writePos);
+    deinterleave(m_scratchBuffer.get(), firstPart);
+    deinterleave(m_scratchBuffer.get() + firstPart * m_numChannels, frameCount - firstPart);
+
+    return frameCount;
 }
 
-void Ingress::bufferSamples()
+void Ingress::deinterleave(const float* frames, int numFrames)
 {
-    int availableFrames = PaUtil_GetRingBufferReadAvailable(m_ringBuffer.get());
-    int readSamples = std::min(availableFrames, m_scratchBufferSize);
-    int frameCount = PaUtil_ReadRingBuffer(m_ringBuffer.get(), m_scratchBuffer.get(), readSamples);
+    for (int i = 0; i < m_numChannels; i++) {
+        m_destinations[i] = &m_history[2 * i * m_historySize + m_writePos];
+        m_mirrorDestinations[i] = m_destinations[i] + m_historySize;
+    }
+    simd::deinterleave(frames, m_numChannels, numFrames, m_destinations.data(), m_mirrorDestinations.data());
 
-    for (int i = 0; i < frameCount * m_numChannels; i++) {
-        m_outputBuffer.get()[m_writePos] = m_scratchBuffer.get()[i];
+    m_writePos += numFrames;
+    if (m_writePos == m_historySize) {
+        m_writePos = 0;
+    }
+}
 
-        m_writePos += 1;
-        if (m_writePos == m_outputBufferSize) {
-            m_writePos = 0;
-        }
+unsigned planFlags(PlanEffort planEffort)
+{
+    switch (planEffort) {
+    case PlanEffort::Estimate:
+        return FFTW_ESTIMATE;
+    case PlanEffort::Patient:
+        return FFTW_PATIENT;
+    default:
+        return FFTW_MEASURE;
     }
 }
 
-FFT::FFT(int fftSize, int channel)
-    : m_channel(channel)
+FFT::FFT(int fftSize, int numChannels, PlanEffort planEffort)
+    : m_numChannels(numChannels)
     , m_bufferSize(fftSize)
     , m_spectrumSize(m_bufferSize / 2 + 1)
+    , m_complexStride(m_spectrumSize + m_spectrumSize % 2)
 {
 
-    m_samples = static_cast<double*>(fftw_malloc(sizeof(double) * m_bufferSize));
-    for (int i = 0; i < m_bufferSize; i++) {
+    m_samples = static_cast<FFTReal*>(FFTW(malloc)(sizeof(FFTReal) * m_bufferSize * m_numChannels));
+    for (int i = 0; i < m_bufferSize * m_numChannels; i++) {
         m_samples[i] = 0;
     }
 
@@ -70,43 +143,41 @@ FFT::FFT(int fftSize, int channel)
         m_window[i] = (-std::cos(t * 2 * 3.14159265358979) + 1) * 0.5;
     }
 
-    m_complexSpectrum = static_cast<fftw_complex*>(
-        fftw_malloc(sizeof(fftw_complex) * m_spectrumSize));
+    m_complexSpectrum = static_cast<FFTComplex*>(
+        FFTW(malloc)(sizeof(FFTComplex) * m_complexStride * m_numChannels));
 
-    m_fftwPlan = fftw_plan_dft_r2c_1d(
-        m_bufferSize, m_samples, m_complexSpectrum, FFTW_MEASURE);
+    m_fftwPlan = FFTW(plan_many_dft_r2c)(
+        1, &m_bufferSize, m_numChannels,
+        m_samples, nullptr, 1, m_bufferSize,
+        m_complexSpectrum, nullptr, 1, m_complexStride,
+        planFlags(planEffort));
 
-    m_magnitudeSpectrum.resize(m_spectrumSize);
+    m_magnitudes.resize(m_spectrumSize * m_numChannels);
 }
 
 FFT::~FFT()
 {
-    fftw_destroy_plan(m_fftwPlan);
-    fftw_free(m_samples);
-    fftw_free(m_complexSpectrum);
+    FFTW(destroy_plan)(m_fftwPlan);
+    FFTW(free)(m_samples);
+    FFTW(free)(m_complexSpectrum);
 }
 
 void FFT::doFFT()
 {
-    fftw_execute(m_fftwPlan);
-
-    for (int i = 0; i < m_spectrumSize; i++) {
-        float real = m_complexSpectrum[i][0];
-        float imag = m_complexSpectrum[i][1];
-        float magnitude = std::hypot(real, imag);
-        float db = 20 * std::log10(magnitude);
-        m_magnitudeSpectrum[i] = db;
+    FFTW(execute)(m_fftwPlan);
+    for (int i = 0; i < m_numChannels; i++) {
+        simd::magnitudeToDb(
+            reinterpret_cast<const FFTReal*>(m_complexSpectrum + i * m_complexStride),
+            &m_magnitudes[i * m_spectrumSize],
+            m_spectrumSize);
     }
 }
 
 void FFT::process(Ingress& ingress)
 {
-    for (int i = 0; i < m_bufferSize; i++) {
-        int index = ingress.getWritePos() + (-m_bufferSize + i) * ingress.getNumChannels() + m_channel;
-        if (index < 0) {
-            index += ingress.getBufferSize();
-        }
-        m_samples[i] = ingress.getOutputBuffer()[index] * m_window[i];
+    for (int i = 0; i < m_numChannels; i++) {
+        simd::multiply(
+            ingress.getHistory(i, m_bufferSize), m_window.data(), m_samples + i * m_bufferSize, m_bufferSize);
     }
     doFFT();
 }
@@ -118,27 +189,21 @@ SpectralMaximum::SpectralMaximum(
     m_magnitudeSpectrum.resize(spectrumSize);
 }
 
-void SpectralMaximum::set(std::vector<float> spectrum)
+void SpectralMaximum::process(const float* magnitudes, int numChannels)
 {
-    for (int i = 0; i < m_spectrumSize; i++) {
-        m_magnitudeSpectrum[i] = spectrum[i];
-    }
-}
-
-void SpectralMaximum::computeMaximumWith(std::vector<float> spectrum)
-{
-    for (int i = 0; i < m_spectrumSize; i++) {
-        m_magnitudeSpectrum[i] = std::max(m_magnitudeSpectrum[i], spectrum[i]);
+    std::copy(magnitudes, magnitudes + m_spectrumSize, m_magnitudeSpectrum.begin());
+    for (int channel = 1; channel < numChannels; channel++) {
+        simd::maximum(
+            m_magnitudeSpectrum.data(),
+            magnitudes + channel * m_spectrumSize,
+            m_magnitudeSpectrum.data(),
+            m_spectrumSize);
     }
 }
 
 float SpectralMaximum::getMaximum()
 {
-    float result = m_magnitudeSpectrum[0];
-    for (int i = 1; i < m_spectrumSize; i++) {
-        result = std::max(result, m_magnitudeSpectrum[i]);
-    }
-    return result;
+    return simd::maximum(m_magnitudeSpectrum.data(), m_spectrumSize);
 }
 
 float RangeComputer::convertValueToScreenY(float value) {
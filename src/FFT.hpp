@@ -1,44 +1,144 @@
 #pragma once
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include <fftw3.h>
 
-#include "pa_ringbuffer.h"
-
+#include "SPSCRing.hpp"
+#include "Trigger.hpp"
+#include "TripleBuffer.hpp"
 #include "portaudio_backend.hpp"
 
+// FFTW precision is chosen at build time. Single precision is the default;
+// NICESCOPE_DOUBLE_PRECISION_FFT switches to the double-precision library,
+// which also makes magnitudes use the exact (slower) dB conversion.
+#ifdef NICESCOPE_DOUBLE_PRECISION_FFT
+typedef double FFTReal;
+typedef fftw_complex FFTComplex;
+typedef fftw_plan FFTPlan;
+#define FFTW(name) fftw_##name
+#else
+typedef float FFTReal;
+typedef fftwf_complex FFTComplex;
+typedef fftwf_plan FFTPlan;
+#define FFTW(name) fftwf_##name
+#endif
+
+struct IngressStats {
+    // Reads that found the producer had lapped them.
+    uint64_t overruns = 0;
+    // Frames overwritten before the analysis side could read them.
+    uint64_t droppedFrames = 0;
+    // Callbacks for which PortAudio reported paInputOverflow.
+    uint64_t inputOverflows = 0;
+    // Callbacks so far, the total time spent in them and the longest one.
+    uint64_t callbacks = 0;
+    double callbackSeconds = 0;
+    double maxCallbackSeconds = 0;
+};
+
+// The ADC time of one frame, counting frames since the Ingress started.
+struct IngressTimestamp {
+    uint64_t frame = 0;
+    double adcTime = 0;
+};
+
+// Receives interleaved audio on the PortAudio callback thread and, on the
+// analysis side, deinterleaves it into one history buffer per channel.
+// Each history is stored twice back to back, so the newest historySize
+// samples of a channel are always one contiguous span.
 class Ingress : public AudioCallback {
 public:
-    Ingress(int numChannels, int fftSize);
-    void process(InputBuffer input_buffer, OutputBuffer output_buffer, int frame_count) override;
-
-    void bufferSamples();
-    const float* getOutputBuffer() { return m_outputBuffer.get(); };
+    Ingress(int numChannels, int historySize);
+    void process(
+        InputBuffer input_buffer,
+        OutputBuffer output_buffer,
+        int frame_count,
+        PaStreamCallbackFlags status_flags,
+        double adc_time) override;
+
+    // Runs the trigger on every block, on the audio callback thread. The
+    // trigger must have as many channels as the Ingress and outlive it.
+    // Call before the audio starts.
+    void setTrigger(Trigger* trigger) { m_trigger = trigger; }
+
+    int getReadAvailable();
+    int bufferSamples(int maxFrames);
+    // Frames the last bufferSamples() found overwritten and skipped, so the
+    // history jumps that far ahead of its previous newest frame.
+    uint64_t getLastDroppedFrames() { return m_lastDroppedFrames; }
+    // The interleaved frames read by the last bufferSamples().
+    const float* getBufferedFrames() { return m_scratchBuffer.get(); }
     int getNumChannels() { return m_numChannels; };
-    int getBufferSize() { return m_outputBufferSize; };
-    int getWritePos() { return m_writePos; };
+    int getHistorySize() { return m_historySize; };
+    // Frames read or dropped so far, which is also the index of the frame
+    // after the newest one in the history.
+    uint64_t getReadFrames() { return m_readFrames; }
+    // Analysis side. The first frame of the newest block from the audio
+    // callback and its ADC time. Frames before and after it are assumed to
+    // follow at the sample rate.
+    IngressTimestamp getLatestTimestamp();
+
+    // The newest `length` samples of a channel, oldest first.
+    const float* getHistory(int channel, int length)
+    {
+        return &m_history[(2 * channel + 1) * m_historySize + m_writePos - length];
+    }
+
+    // Safe to call from any thread.
+    IngressStats getStats();
 
 private:
     const int m_numChannels;
-    const int m_ringBufferSize;
-    const int m_scratchBufferSize;
-    const int m_outputBufferSize;
+    const int m_historySize;
 
     int m_writePos = 0;
 
-    std::unique_ptr<PaUtilRingBuffer> m_ringBuffer;
-    std::unique_ptr<float[]> m_ringBufferData;
+    SPSCRing m_ring;
+    Trigger* m_trigger = nullptr;
+
+    // Written by the audio callback only.
+    alignas(k_cacheLineSize) std::atomic<uint64_t> m_inputOverflows;
+    std::atomic<uint64_t> m_callbacks;
+    std::atomic<uint64_t> m_callbackNanoseconds;
+    std::atomic<uint64_t> m_maxCallbackNanoseconds;
+    uint64_t m_writtenFrames = 0;
+    TripleBuffer<IngressTimestamp> m_timestamps;
+
+    // Written by the consumer only.
+    alignas(k_cacheLineSize) std::atomic<uint64_t> m_overruns;
+    std::atomic<uint64_t> m_droppedFrames;
+    uint64_t m_readFrames = 0;
+    uint64_t m_lastDroppedFrames = 0;
 
     std::unique_ptr<float[]> m_scratchBuffer;
 
-    std::unique_ptr<float[]> m_outputBuffer;
+    std::unique_ptr<float[]> m_history;
+    std::vector<float*> m_destinations;
+    std::vector<float*> m_mirrorDestinations;
+
+    void deinterleave(const float* frames, int numFrames);
+};
+
+// How hard FFTW searches for a fast plan. Higher efforts take longer to plan
+// but are free once their wisdom has been cached.
+enum class PlanEffort {
+    Estimate,
+    Measure,
+    Patient
 };
 
+unsigned planFlags(PlanEffort planEffort);
+
+// Transforms every channel of an Ingress with one batched FFTW plan. The
+// window is shared, and the results land in one contiguous [channel][bin]
+// matrix of magnitudes in dB.
 class FFT {
 public:
-    FFT(int fftSize, int m_channel);
+    FFT(int fftSize, int numChannels, PlanEffort planEffort);
     ~FFT();
 
     FFT(const FFT& other) = delete;
@@ -48,31 +148,35 @@ public:
 
     int getBufferSize() { return m_bufferSize; }
     int getSpectrumSize() { return m_spectrumSize; }
+    int getNumChannels() { return m_numChannels; }
 
     void process(Ingress& ingress);
 
-    std::vector<float>& getMagnitudeSpectrum() { return m_magnitudeSpectrum; }
+    const std::vector<float>& getMagnitudes() { return m_magnitudes; }
+    const float* getMagnitudeSpectrum(int channel) { return &m_magnitudes[channel * m_spectrumSize]; }
 
 private:
-    const int m_channel;
+    const int m_numChannels;
     const int m_bufferSize;
     const int m_spectrumSize;
-    float m_maxDb = -90.0f;
-    double* m_samples;
-    fftw_complex* m_complexSpectrum;
-    fftw_plan m_fftwPlan;
+    // Complex rows are padded to an even length so every channel's output
+    // starts on the same SIMD alignment.
+    const int m_complexStride;
+    FFTReal* m_samples;
+    FFTComplex* m_complexSpectrum;
+    FFTPlan m_fftwPlan;
     void doFFT();
     std::vector<float> m_window;
-    std::vector<float> m_magnitudeSpectrum;
+    std::vector<float> m_magnitudes;
 };
 
 class SpectralMaximum {
 public:
     SpectralMaximum(int spectrumSize);
 
-    std::vector<float>& getMagnitudeSpectrum() { return m_magnitudeSpectrum; };
-    void set(std::vector<float> spectrum);
-    void computeMaximumWith(std::vector<float> spectrum);
+    const std::vector<float>& getMagnitudeSpectrum() { return m_magnitudeSpectrum; };
+    // Elementwise maximum over the rows of a [channel][bin] matrix.
+    void process(const float* magnitudes, int numChannels);
     float getMaximum();
 
 private:
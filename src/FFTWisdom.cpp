@@ -0,0 +1,88 @@
+#include "FFTWisdom.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef NICESCOPE_DOUBLE_PRECISION_FFT
+static const char* k_wisdomFileName = "fftw-wisdom-double";
+#else
+static const char* k_wisdomFileName = "fftw-wisdom-float";
+#endif
+
+static bool makeDirectories(const std::string& path)
+{
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            std::string prefix = path.substr(0, i);
+            if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+FFTWisdom::FFTWisdom()
+    : m_path(getCacheDirectory() + "/" + k_wisdomFileName)
+{
+}
+
+const std::vector<int>& FFTWisdom::getSupportedSizes()
+{
+    static const std::vector<int> sizes = {
+        256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144
+    };
+    return sizes;
+}
+
+std::string FFTWisdom::getCacheDirectory()
+{
+    const char* home = std::getenv("HOME");
+    std::string homeDirectory = home ? home : ".";
+#if (__APPLE__)
+    return homeDirectory + "/Library/Caches/NiceScope";
+#else
+    const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+    if (cacheHome && cacheHome[0] == '/') {
+        return std::string(cacheHome) + "/nicescope";
+    }
+    return homeDirectory + "/.cache/nicescope";
+#endif
+}
+
+bool FFTWisdom::load()
+{
+    return FFTW(import_wisdom_from_filename)(m_path.c_str()) != 0;
+}
+
+void FFTWisdom::save()
+{
+    std::string directory = m_path.substr(0, m_path.rfind('/'));
+    if (!makeDirectories(directory)) {
+        std::cerr << "Couldn't create " << directory << ", not saving FFTW wisdom." << std::endl;
+        return;
+    }
+    // Write to a temporary file first so a concurrent launch never reads a
+    // half-written wisdom file.
+    std::string temporaryPath = m_path + ".tmp";
+    if (!FFTW(export_wisdom_to_filename)(temporaryPath.c_str())
+        || std::rename(temporaryPath.c_str(), m_path.c_str()) != 0) {
+        std::cerr << "Couldn't write FFTW wisdom to " << m_path << "." << std::endl;
+    }
+}
+
+void FFTWisdom::prewarm(const std::vector<int>& channelCounts, PlanEffort effort)
+{
+    for (int size : getSupportedSizes()) {
+        for (int numChannels : channelCounts) {
+            std::cerr << "Planning " << size << "-point FFT for "
+                      << numChannels << " channel(s)..." << std::endl;
+            FFT fft(size, numChannels, effort);
+        }
+        // Save as we go so an interrupted prewarm keeps its progress.
+        save();
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "FFT.hpp"
+
+// FFTW wisdom persisted in the user's cache directory, so that plans
+// measured once are reused on every later launch. Wisdom is kept per FFTW
+// precision because the two libraries cannot read each other's.
+class FFTWisdom {
+public:
+    FFTWisdom();
+
+    const std::string& getPath() { return m_path; }
+
+    // Returns false if there was no usable wisdom file.
+    bool load();
+    void save();
+
+    // Plans every supported FFT size for each of the given channel counts
+    // and saves the result.
+    void prewarm(const std::vector<int>& channelCounts, PlanEffort effort);
+
+    static const std::vector<int>& getSupportedSizes();
+
+private:
+    std::string m_path;
+
+    static std::string getCacheDirectory();
+};
@@ -0,0 +1,93 @@
+#include "FrameTimer.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+FrameTimer::FrameTimer(int warmUpFrames)
+    : m_warmUpFrames(warmUpFrames)
+    , m_hasTimerQueries(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+{
+    if (m_hasTimerQueries) {
+        glGenQueries(k_queryLatency, m_queries);
+    }
+}
+
+FrameTimer::~FrameTimer()
+{
+    if (m_hasTimerQueries) {
+        glDeleteQueries(k_queryLatency, m_queries);
+    }
+}
+
+void FrameTimer::beginFrame()
+{
+    if (m_hasTimerQueries) {
+        if (m_frame - m_collected == k_queryLatency) {
+            collect(m_collected++);
+        }
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_frame % k_queryLatency]);
+    }
+    m_frameStart = std::chrono::steady_clock::now();
+}
+
+void FrameTimer::endFrame()
+{
+    auto frameEnd = std::chrono::steady_clock::now();
+    if (m_hasTimerQueries) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    if (m_frame >= m_warmUpFrames) {
+        m_cpuMilliseconds.push_back(std::chrono::duration<double, std::milli>(frameEnd - m_frameStart).count());
+    }
+    m_frame++;
+}
+
+void FrameTimer::finish()
+{
+    if (!m_hasTimerQueries) {
+        return;
+    }
+    while (m_collected < m_frame) {
+        collect(m_collected++);
+    }
+}
+
+void FrameTimer::collect(int frame)
+{
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(m_queries[frame % k_queryLatency], GL_QUERY_RESULT, &nanoseconds);
+    if (frame >= m_warmUpFrames) {
+        m_gpuMilliseconds.push_back(nanoseconds / 1e6);
+    }
+}
+
+static void reportPercentiles(std::ostream& stream, const char* name, std::vector<double> times)
+{
+    if (times.empty()) {
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) {
+        return times[std::min(times.size() - 1, static_cast<size_t>(p / 100 * times.size()))];
+    };
+    stream << name << " ms: p50 " << percentile(50)
+           << ", p90 " << percentile(90)
+           << ", p99 " << percentile(99)
+           << ", max " << times.back() << std::endl;
+}
+
+void FrameTimer::report(std::ostream& stream)
+{
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(3);
+    stream << m_cpuMilliseconds.size() << " frames timed after " << m_warmUpFrames << " warm-up frames" << std::endl;
+    reportPercentiles(stream, "CPU", m_cpuMilliseconds);
+    if (m_hasTimerQueries) {
+        reportPercentiles(stream, "GPU", m_gpuMilliseconds);
+    } else {
+        stream << "GPU times unavailable: no timer queries in this context" << std::endl;
+    }
+    stream.flags(flags);
+    stream.precision(precision);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <GL/glew.h>
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+// Per-frame CPU and GPU times. CPU time is wall time between beginFrame()
+// and endFrame(); GPU time comes from GL_TIME_ELAPSED queries where the
+// context has timer queries. Query results are collected k_queryLatency
+// frames late, so reading them never waits on the GPU.
+class FrameTimer {
+public:
+    explicit FrameTimer(int warmUpFrames);
+    ~FrameTimer();
+
+    FrameTimer(const FrameTimer& other) = delete;
+    FrameTimer& operator=(const FrameTimer& other) = delete;
+
+    bool hasGPUTimes() { return m_hasTimerQueries; }
+
+    void beginFrame();
+    void endFrame();
+    // Collects the outstanding queries. Call once after the last frame.
+    void finish();
+
+    // Prints percentiles of the frames after the warm-up.
+    void report(std::ostream& stream);
+
+private:
+    static const int k_queryLatency = 4;
+
+    const int m_warmUpFrames;
+    const bool m_hasTimerQueries;
+    GLuint m_queries[k_queryLatency];
+    int m_frame = 0;
+    int m_collected = 0;
+    std::chrono::steady_clock::time_point m_frameStart;
+
+    std::vector<double> m_cpuMilliseconds;
+    std::vector<double> m_gpuMilliseconds;
+
+    void collect(int frame);
+};
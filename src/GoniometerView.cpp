@@ -0,0 +1,164 @@
+#include "GoniometerView.hpp"
+#include "Colors.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// The pair at ring index gl_VertexID is (newest - gl_VertexID) mod
+// numPoints pairs old.
+static const char* k_vertexShaderSource = ("#version 140\n"
+                                           "in vec2 pair;\n"
+                                           "uniform int newest;\n"
+                                           "uniform int numPoints;\n"
+                                           "uniform vec4 color;\n"
+                                           "out vec4 pointColor;\n"
+                                           "void main()\n"
+                                           "{\n"
+                                           "    int age = (newest - gl_VertexID + numPoints) % numPoints;\n"
+                                           "    pointColor = vec4(color.rgb, color.a * (1.0 - float(age) / float(numPoints)));\n"
+                                           "    vec2 position = 0.70710678 * vec2(pair.y - pair.x, pair.x + pair.y);\n"
+                                           "    gl_Position = vec4(clamp(position, -1.0, 1.0), 0, 1);\n"
+                                           "    gl_PointSize = 2.0;\n"
+                                           "}\n");
+
+static const char* k_fragmentShaderSource = ("#version 140\n"
+                                             "in vec4 pointColor;\n"
+                                             "out vec4 fragColor;\n"
+                                             "void main()\n"
+                                             "{\n"
+                                             "    fragColor = pointColor;\n"
+                                             "}\n");
+
+// Height of the correlation meter under the points, in pixels.
+static const int k_meterHeight = 6;
+// Integration time of the correlation meter, as on hardware meters.
+static const float k_correlationTimeConstant = 0.3;
+
+GoniometerView::GoniometerView(
+    SPSCRing& tap, int numChannels, float sampleRate, int numPoints, std::array<float, 4> background)
+    : m_numChannels(numChannels)
+    , m_numPoints(numPoints)
+    , m_background(background)
+    , m_tap(tap)
+    , m_correlationMeter(sampleRate, k_correlationTimeConstant)
+    , m_readBuffer(k_readSize * numChannels)
+{
+    if (numChannels < 2) {
+        throw std::runtime_error("The goniometer needs two channels");
+    }
+    if (numPoints < 1) {
+        throw std::runtime_error("The goniometer needs at least one point");
+    }
+
+    m_shaderProgram.reset(new ShaderProgram(k_vertexShaderSource, k_fragmentShaderSource));
+    m_program = m_shaderProgram->getProgram();
+    m_newestLocation = glGetUniformLocation(m_program, "newest");
+    m_numPointsLocation = glGetUniformLocation(m_program, "numPoints");
+    m_colorLocation = glGetUniformLocation(m_program, "color");
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glGenBuffers(1, &m_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    std::vector<float> silence(2 * numPoints, 0);
+    glBufferData(GL_ARRAY_BUFFER, silence.size() * sizeof(float), silence.data(), GL_STREAM_DRAW);
+    GLint pair = m_shaderProgram->getAttribLocation("pair");
+    glVertexAttribPointer(pair, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(pair);
+    glBindVertexArray(0);
+}
+
+GoniometerView::~GoniometerView()
+{
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteVertexArrays(1, &m_vao);
+}
+
+bool GoniometerView::isSupported()
+{
+    return GLEW_VERSION_3_1;
+}
+
+void GoniometerView::drainTap()
+{
+    m_pairs.clear();
+    while (true) {
+        uint64_t droppedFrames = 0;
+        int numFrames = m_tap.read(m_readBuffer.data(), k_readSize, droppedFrames);
+        if (numFrames == 0) {
+            return;
+        }
+        m_correlationMeter.process(m_readBuffer.data(), m_numChannels, numFrames);
+        for (int i = 0; i < numFrames; i++) {
+            m_pairs.push_back(m_readBuffer[i * m_numChannels]);
+            m_pairs.push_back(m_readBuffer[i * m_numChannels + 1]);
+        }
+    }
+}
+
+// Writes pairs into the ring from m_writePoint on, wrapping at the end.
+void GoniometerView::upload(const float* pairs, int numPairs)
+{
+    // Only the newest numPoints pairs can be seen.
+    if (numPairs > m_numPoints) {
+        pairs += 2 * (numPairs - m_numPoints);
+        numPairs = m_numPoints;
+    }
+    int firstPart = std::min(numPairs, m_numPoints - m_writePoint);
+    glBufferSubData(GL_ARRAY_BUFFER, 2 * sizeof(float) * m_writePoint, 2 * sizeof(float) * firstPart, pairs);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, 2 * sizeof(float) * (numPairs - firstPart), pairs + 2 * firstPart);
+    m_writePoint = (m_writePoint + numPairs) % m_numPoints;
+}
+
+void GoniometerView::render(int x, int y, int size)
+{
+    drainTap();
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    if (!m_pairs.empty()) {
+        upload(m_pairs.data(), m_pairs.size() / 2);
+    }
+
+    int plotSize = size - 2 * k_meterHeight;
+    if (plotSize > 0) {
+        glViewport(x, y + 2 * k_meterHeight, size, plotSize);
+        glUseProgram(m_program);
+        glUniform1i(m_newestLocation, (m_writePoint + m_numPoints - 1) % m_numPoints);
+        glUniform1i(m_numPointsLocation, m_numPoints);
+        std::array<float, 4> color = channelColor(1, 0.8);
+        glUniform4fv(m_colorLocation, 1, color.data());
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glDrawArrays(GL_POINTS, 0, m_numPoints);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+    glBindVertexArray(0);
+
+    renderCorrelation(x, y, size);
+}
+
+// A track the width of the goniometer with a bar from its center to the
+// correlation, drawn with scissored clears.
+void GoniometerView::renderCorrelation(int x, int y, int size)
+{
+    float correlation = getCorrelation();
+    int center = x + size / 2;
+    int end = x + static_cast<int>((correlation + 1) / 2 * size);
+
+    glEnable(GL_SCISSOR_TEST);
+
+    std::array<float, 4> track = colorFromHex(0x373b41);
+    glScissor(x, y, size, k_meterHeight);
+    glClearColor(track[0], track[1], track[2], track[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Green-ish for mostly mono, red for mostly out of phase.
+    std::array<float, 4> bar = colorFromHex(correlation >= 0 ? 0xb5bd68 : 0xcc6666);
+    glScissor(std::min(center, end), y, std::max(1, std::abs(end - center)), k_meterHeight);
+    glClearColor(bar[0], bar[1], bar[2], bar[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(m_background[0], m_background[1], m_background[2], m_background[3]);
+}
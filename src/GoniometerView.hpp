@@ -0,0 +1,62 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "CorrelationMeter.hpp"
+#include "SPSCRing.hpp"
+#include "ShaderProgram.hpp"
+
+// Goniometer of the first two channels: the newest numPoints L/R pairs as
+// points, rotated 45 degrees so mono is vertical and out-of-phase content
+// horizontal, with a correlation meter under them. The pairs live in one
+// vertex buffer used as a ring. Each frame uploads only the pairs that
+// arrived since the last one, with glBufferSubData, and draws the whole
+// ring as points in one call. Point order does not matter, and the shader
+// fades points by their age in the ring. Needs OpenGL 3.1.
+class GoniometerView {
+public:
+    // The tap must outlive the view, and have at least two channels. The
+    // correlation meter is drawn with scissored clears, after which the
+    // clear color is set back to background.
+    GoniometerView(SPSCRing& tap, int numChannels, float sampleRate, int numPoints, std::array<float, 4> background);
+    ~GoniometerView();
+
+    GoniometerView(const GoniometerView& other) = delete;
+    GoniometerView& operator=(const GoniometerView& other) = delete;
+
+    static bool isSupported();
+
+    float getCorrelation() { return m_correlationMeter.getCorrelation(); }
+
+    // Takes in the audio that arrived since the last call and draws into
+    // the square of the window with lower left corner (x, y).
+    void render(int x, int y, int size);
+
+private:
+    // Frames read from the tap at a time.
+    static const int k_readSize = 4096;
+
+    const int m_numChannels;
+    const int m_numPoints;
+    const std::array<float, 4> m_background;
+    SPSCRing& m_tap;
+    CorrelationMeter m_correlationMeter;
+    std::vector<float> m_readBuffer;
+    // L/R pairs not yet uploaded.
+    std::vector<float> m_pairs;
+    int m_writePoint = 0;
+
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    GLuint m_program;
+    GLint m_newestLocation;
+    GLint m_numPointsLocation;
+    GLint m_colorLocation;
+    GLuint m_vao;
+    GLuint m_vbo;
+
+    void drainTap();
+    void upload(const float* pairs, int numPairs);
+    void renderCorrelation(int x, int y, int size);
+};
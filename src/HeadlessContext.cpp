@@ -0,0 +1,98 @@
+#include "HeadlessContext.hpp"
+
+#include <stdexcept>
+
+#ifdef NICESCOPE_HAVE_EGL
+#include <EGL/eglext.h>
+
+static EGLDisplay getDisplay()
+{
+    // Prefer Mesa's surfaceless platform, which needs neither X nor a GPU
+    // device node, and fall back to whatever the default display is.
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+    }
+#endif
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        throw std::runtime_error("Could not open an EGL display.");
+    }
+    return display;
+}
+
+HeadlessContext::HeadlessContext(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+    m_display = getDisplay();
+
+    // The context never draws to an EGL surface, so accept any surface type.
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(m_display, configAttributes, &config, 1, &numConfigs) || numConfigs < 1
+        || !eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(m_display);
+        throw std::runtime_error("EGL display does not support desktop OpenGL.");
+    }
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, nullptr);
+    if (m_context == EGL_NO_CONTEXT
+        || !eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        eglTerminate(m_display);
+        throw std::runtime_error("Could not create a surfaceless OpenGL context.");
+    }
+
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    if (!glCreateShader || !glGenFramebuffers) {
+        eglTerminate(m_display);
+        throw std::runtime_error("Headless rendering needs OpenGL 3.0.");
+    }
+
+    glGenRenderbuffers(1, &m_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        eglTerminate(m_display);
+        throw std::runtime_error("Could not create the offscreen framebuffer.");
+    }
+    glViewport(0, 0, width, height);
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteRenderbuffers(1, &m_colorBuffer);
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+}
+
+#else
+
+HeadlessContext::HeadlessContext(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+    throw std::runtime_error("NiceScope was built without EGL, so it cannot run headless.");
+}
+
+HeadlessContext::~HeadlessContext()
+{
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <GL/glew.h>
+
+#ifdef NICESCOPE_HAVE_EGL
+#include <EGL/egl.h>
+#endif
+
+// An OpenGL context with no window, rendering into a framebuffer object of
+// a fixed size. Uses EGL on a surfaceless display where the driver offers
+// one (Mesa), so it runs without a display server. Left current and bound
+// for the lifetime of the object.
+class HeadlessContext {
+public:
+    // Throws if NiceScope was built without EGL or no context can be made.
+    HeadlessContext(int width, int height);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext& other) = delete;
+    HeadlessContext& operator=(const HeadlessContext& other) = delete;
+
+    int getWidth() { return m_width; }
+    int getHeight() { return m_height; }
+
+private:
+    const int m_width;
+    const int m_height;
+#ifdef NICESCOPE_HAVE_EGL
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+#endif
+    GLuint m_framebuffer = 0;
+    GLuint m_colorBuffer = 0;
+};
@@ -0,0 +1,23 @@
+#include "LiveAnalysis.hpp"
+
+#include <algorithm>
+
+LiveAnalysis::LiveAnalysis(const Options& options, float sampleRate, FFTWisdom& wisdom)
+    : m_engine(makeAnalysisEngine(options, sampleRate))
+    , m_lowestFrequency(m_engine->getLowestFrequency())
+    , m_highestFrequency(m_engine->getHighestFrequency())
+    , m_ingress(options.numChannels, std::max(m_engine->getLongestWindow(), m_engine->getHopSize()))
+    , m_analyzer(m_ingress, std::move(m_engine), sampleRate, options.accumulators)
+{
+    wisdom.save();
+    if (!options.shmName.empty()) {
+        m_publisher.reset(new SharedMemoryPublisher(
+            options.shmName,
+            m_analyzer.getBinFrequencies(),
+            options.numChannels,
+            sampleRate,
+            m_lowestFrequency,
+            m_highestFrequency));
+        m_analyzer.setPublisher(*m_publisher);
+    }
+}
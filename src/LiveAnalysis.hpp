@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+
+#include "Analyzer.hpp"
+#include "FFT.hpp"
+#include "FFTWisdom.hpp"
+#include "Options.hpp"
+#include "SharedMemoryPublisher.hpp"
+
+// The analysis chain for live audio, shared by the window and the daemon:
+// the engine picked by the options, an Ingress with room for its longest
+// window, the Analyzer draining it and, with --shm, the publisher of its
+// frames. The audio source and whatever shows the frames stay with the
+// caller.
+class LiveAnalysis {
+public:
+    // Plans the engine with the given wisdom and saves what it learned.
+    LiveAnalysis(const Options& options, float sampleRate, FFTWisdom& wisdom);
+
+    LiveAnalysis(const LiveAnalysis& other) = delete;
+    LiveAnalysis& operator=(const LiveAnalysis& other) = delete;
+
+    Ingress& getIngress() { return m_ingress; }
+    Analyzer& getAnalyzer() { return m_analyzer; }
+    float getLowestFrequency() { return m_lowestFrequency; }
+    float getHighestFrequency() { return m_highestFrequency; }
+
+private:
+    // Only held until the Analyzer takes it over.
+    std::unique_ptr<AnalysisEngine> m_engine;
+    const float m_lowestFrequency;
+    const float m_highestFrequency;
+    Ingress m_ingress;
+    // Declared before the Analyzer so that it outlives the analysis thread.
+    std::unique_ptr<SharedMemoryPublisher> m_publisher;
+    Analyzer m_analyzer;
+};
@@ -0,0 +1,125 @@
+#include "MinMaxPyramid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+MinMaxPyramid::MinMaxPyramid(int numChannels, int capacity)
+    : m_numChannels(numChannels)
+    , m_levels(numChannels)
+{
+    // Power-of-two rings so every level's entries can be found by masking,
+    // and a level's two children are always still in the level below.
+    m_capacity = k_minimumEntries;
+    while (m_capacity < capacity) {
+        m_capacity *= 2;
+    }
+    m_numLevels = 1;
+    while ((m_capacity >> m_numLevels) >= k_minimumEntries) {
+        m_numLevels++;
+    }
+
+    for (auto& levels : m_levels) {
+        levels.resize(m_numLevels);
+        levels[0].minima.resize(m_capacity, 0);
+        for (int level = 1; level < m_numLevels; level++) {
+            levels[level].minima.resize(m_capacity >> level, 0);
+            levels[level].maxima.resize(m_capacity >> level, 0);
+        }
+    }
+}
+
+float MinMaxPyramid::getMinimum(int channel, int level, uint64_t entry)
+{
+    const Level& theLevel = m_levels[channel][level];
+    return theLevel.minima[entry & ((m_capacity >> level) - 1)];
+}
+
+float MinMaxPyramid::getMaximum(int channel, int level, uint64_t entry)
+{
+    const Level& theLevel = m_levels[channel][level];
+    const std::vector<float>& maxima = level == 0 ? theLevel.minima : theLevel.maxima;
+    return maxima[entry & ((m_capacity >> level) - 1)];
+}
+
+void MinMaxPyramid::push(const float* interleaved, int numFrames)
+{
+    // A level's new entries are built from the level below after all of
+    // this push's samples are in, so the level below must not wrap within
+    // one push.
+    int maxFrames = m_capacity / 2;
+    while (numFrames > maxFrames) {
+        push(interleaved, maxFrames);
+        interleaved += maxFrames * m_numChannels;
+        numFrames -= maxFrames;
+    }
+
+    uint64_t mask = m_capacity - 1;
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        std::vector<float>& samples = m_levels[channel][0].minima;
+        for (int i = 0; i < numFrames; i++) {
+            samples[(m_written + i) & mask] = interleaved[i * m_numChannels + channel];
+        }
+    }
+
+    uint64_t written = m_written + numFrames;
+    for (int level = 1; level < m_numLevels; level++) {
+        uint64_t first = m_written >> level;
+        uint64_t end = written >> level;
+        if (first == end) {
+            // Coarser levels complete entries even less often.
+            break;
+        }
+        uint64_t levelMask = (m_capacity >> level) - 1;
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            Level& theLevel = m_levels[channel][level];
+            for (uint64_t entry = first; entry < end; entry++) {
+                theLevel.minima[entry & levelMask] = std::min(
+                    getMinimum(channel, level - 1, 2 * entry), getMinimum(channel, level - 1, 2 * entry + 1));
+                theLevel.maxima[entry & levelMask] = std::max(
+                    getMaximum(channel, level - 1, 2 * entry), getMaximum(channel, level - 1, 2 * entry + 1));
+            }
+        }
+    }
+    m_written = written;
+}
+
+void MinMaxPyramid::getColumns(int channel, double span, int numColumns, float* minima, float* maxima)
+{
+    span = std::min(span, static_cast<double>(m_capacity));
+    double samplesPerColumn = span / numColumns;
+
+    // The coarsest level whose entries are no longer than a column.
+    int level = 0;
+    while (level + 1 < m_numLevels && std::ldexp(1.0, level + 1) <= samplesPerColumn) {
+        level++;
+    }
+    double entriesPerColumn = std::ldexp(samplesPerColumn, -level);
+    // Only complete entries, and only those the ring still holds.
+    double end = static_cast<double>(m_written >> level);
+    uint64_t oldest = end > (m_capacity >> level) ? static_cast<uint64_t>(end) - (m_capacity >> level) : 0;
+    double start = end - span / std::ldexp(1.0, level);
+
+    for (int i = 0; i < numColumns; i++) {
+        double from = start + i * entriesPerColumn;
+        double to = from + entriesPerColumn;
+        // Every column covers at least one entry, which at level 0 and
+        // less than a sample per column means the nearest sample.
+        int64_t first = static_cast<int64_t>(std::floor(from));
+        int64_t last = std::max(first, static_cast<int64_t>(std::ceil(to)) - 1);
+        first = std::max<int64_t>(first, oldest);
+        last = std::min<int64_t>(last, static_cast<int64_t>(end) - 1);
+        if (first > last) {
+            minima[i] = 0;
+            maxima[i] = 0;
+            continue;
+        }
+        float minimum = getMinimum(channel, level, first);
+        float maximum = getMaximum(channel, level, first);
+        for (int64_t entry = first + 1; entry <= last; entry++) {
+            minimum = std::min(minimum, getMinimum(channel, level, entry));
+            maximum = std::max(maximum, getMaximum(channel, level, entry));
+        }
+        minima[i] = minimum;
+        maxima[i] = maximum;
+    }
+}
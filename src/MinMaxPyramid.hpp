@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Per channel, a ring of the most recent samples and a pyramid of rings
+// above it: level k holds the minimum and maximum of each aligned run of
+// 2^k samples, level k + 1 is built from pairs of level k entries. Levels
+// are updated incrementally as samples arrive, at an amortized cost of
+// about one comparison pair per sample. getColumns() reads any span from
+// the coarsest level that still has an entry per column, so its cost
+// depends on the number of columns and not on the span.
+class MinMaxPyramid {
+public:
+    // Keeps at least `capacity` samples of every channel.
+    MinMaxPyramid(int numChannels, int capacity);
+
+    int getCapacity() { return m_capacity; }
+    // Total frames pushed so far.
+    uint64_t getWritten() { return m_written; }
+
+    void push(const float* interleaved, int numFrames);
+
+    // Minimum and maximum of channel for each of numColumns equal slices of
+    // the newest `span` samples, oldest first. span is clamped to the
+    // capacity. Columns with no samples yet read 0.
+    void getColumns(int channel, double span, int numColumns, float* minima, float* maxima);
+
+private:
+    struct Level {
+        std::vector<float> minima;
+        // Empty at level 0, where the minimum of a run of one is the sample.
+        std::vector<float> maxima;
+    };
+
+    // Level entries are kept while there are at least this many of them.
+    static const int k_minimumEntries = 64;
+
+    const int m_numChannels;
+    int m_capacity;
+    uint64_t m_written = 0;
+    // [channel][level]
+    std::vector<std::vector<Level>> m_levels;
+    int m_numLevels;
+
+    float getMinimum(int channel, int level, uint64_t entry);
+    float getMaximum(int channel, int level, uint64_t entry);
+};
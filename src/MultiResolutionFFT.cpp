@@ -0,0 +1,135 @@
+#include "MultiResolutionFFT.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<AnalysisBand> parseAnalysisBands(const std::string& spec, float sampleRate)
+{
+    std::vector<AnalysisBand> bands;
+    float lowFrequency = 0;
+
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!bands.empty() && bands.back().highFrequency >= sampleRate / 2) {
+            throw std::runtime_error("Only the last band may omit its upper frequency");
+        }
+        AnalysisBand band;
+        size_t colon = item.find(':');
+        band.fftSize = std::stoi(item.substr(0, colon));
+        band.lowFrequency = lowFrequency;
+        band.highFrequency = colon == std::string::npos
+            ? sampleRate / 2
+            : std::stof(item.substr(colon + 1));
+        if (band.fftSize < 16 || band.fftSize % 2 != 0) {
+            throw std::runtime_error("Band FFT sizes must be even and at least 16");
+        }
+        if (band.highFrequency <= band.lowFrequency) {
+            throw std::runtime_error("Band upper frequencies must be increasing");
+        }
+        bands.push_back(band);
+        lowFrequency = band.highFrequency;
+    }
+
+    if (bands.empty() || bands.back().highFrequency < sampleRate / 2) {
+        throw std::runtime_error("The last band must extend to Nyquist (omit its upper frequency)");
+    }
+    return bands;
+}
+
+int MultiResolutionFFT::hopSizeFromOverlap(int fftSize, float overlapPercent)
+{
+    if (overlapPercent < 0 || overlapPercent >= 100) {
+        throw std::runtime_error("Overlap must be at least 0% and less than 100%.");
+    }
+    return std::max(1, static_cast<int>(std::round(fftSize * (1 - overlapPercent / 100))));
+}
+
+MultiResolutionFFT::MultiResolutionFFT(
+    const std::vector<AnalysisBand>& bands,
+    int numChannels,
+    float sampleRate,
+    float overlapPercent,
+    int referenceFFTSize,
+    PlanEffort planEffort)
+    : m_numChannels(numChannels)
+    , m_hopSize(INT_MAX)
+    , m_longestWindow(0)
+{
+    int outputOffset = 0;
+    for (int i = 0; i < static_cast<int>(bands.size()); i++) {
+        const AnalysisBand& analysisBand = bands[i];
+        bool isLastBand = i == static_cast<int>(bands.size()) - 1;
+
+        Band band;
+        band.fft.reset(new FFT(analysisBand.fftSize, numChannels, planEffort));
+        band.hopSize = hopSizeFromOverlap(analysisBand.fftSize, overlapPercent);
+        // Transform on the first hop rather than waiting a full band hop.
+        band.framesSinceTransform = band.hopSize;
+
+        float binWidth = sampleRate / analysisBand.fftSize;
+        int spectrumSize = band.fft->getSpectrumSize();
+        band.firstBin = std::min(static_cast<int>(std::ceil(analysisBand.lowFrequency / binWidth)), spectrumSize);
+        int endBin = isLastBand
+            ? spectrumSize
+            : std::min(static_cast<int>(std::ceil(analysisBand.highFrequency / binWidth)), spectrumSize);
+        band.numBins = std::max(endBin - band.firstBin, 0);
+        band.outputOffset = outputOffset;
+        band.gainDb = 20 * std::log10(static_cast<float>(referenceFFTSize) / analysisBand.fftSize);
+
+        for (int bin = band.firstBin; bin < endBin; bin++) {
+            m_binFrequencies.push_back(bin * binWidth);
+        }
+        outputOffset += band.numBins;
+
+        m_hopSize = std::min(m_hopSize, band.hopSize);
+        m_longestWindow = std::max(m_longestWindow, analysisBand.fftSize);
+        m_bands.push_back(std::move(band));
+    }
+
+    m_magnitudes.resize(m_numChannels * m_binFrequencies.size(), -1000);
+}
+
+bool MultiResolutionFFT::canStartMidStream()
+{
+    int windowHops = (m_longestWindow + m_hopSize - 1) / m_hopSize;
+    for (const Band& band : m_bands) {
+        if (band.hopSize % m_hopSize != 0 || windowHops % (band.hopSize / m_hopSize) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MultiResolutionFFT::process(Ingress& ingress, int frameCount, uint64_t droppedFrames)
+{
+    // A short read only brings the bands that much closer to their next
+    // transform. Dropped frames need nothing: every transform reads the
+    // newest window, whatever came before it.
+    bool updated = false;
+    for (Band& band : m_bands) {
+        band.framesSinceTransform += frameCount;
+        if (band.framesSinceTransform < band.hopSize) {
+            continue;
+        }
+        band.framesSinceTransform -= band.hopSize;
+        band.fft->process(ingress);
+        copyBand(band);
+        updated = true;
+    }
+    return updated;
+}
+
+void MultiResolutionFFT::copyBand(Band& band)
+{
+    int spectrumSize = getSpectrumSize();
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        const float* source = band.fft->getMagnitudeSpectrum(channel) + band.firstBin;
+        float* destination = &m_magnitudes[channel * spectrumSize + band.outputOffset];
+        for (int i = 0; i < band.numBins; i++) {
+            destination[i] = source[i] + band.gainDb;
+        }
+    }
+}
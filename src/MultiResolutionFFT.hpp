@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AnalysisEngine.hpp"
+#include "FFT.hpp"
+
+// One frequency band of a multi-resolution analysis: bins of an fftSize-point
+// FFT from lowFrequency up to (but excluding) highFrequency.
+struct AnalysisBand {
+    int fftSize;
+    float lowFrequency;
+    float highFrequency;
+};
+
+// Parses "size:upper,size:upper,...,size", e.g. "32768:200,4096:2500,512".
+// Bands are listed from low to high; the last one extends to Nyquist.
+std::vector<AnalysisBand> parseAnalysisBands(const std::string& spec, float sampleRate);
+
+// Runs one FFT per band, each at a hop rate proportional to its own size,
+// and stitches their bins into a single spectrum ordered by frequency. Band
+// levels are normalized to referenceFFTSize so a steady sine reads the same
+// in every band.
+class MultiResolutionFFT : public AnalysisEngine {
+public:
+    MultiResolutionFFT(
+        const std::vector<AnalysisBand>& bands,
+        int numChannels,
+        float sampleRate,
+        float overlapPercent,
+        int referenceFFTSize,
+        PlanEffort planEffort);
+
+    static int hopSizeFromOverlap(int fftSize, float overlapPercent);
+
+    // The smallest band hop.
+    int getHopSize() override { return m_hopSize; }
+    int getLongestWindow() override { return m_longestWindow; }
+    int getNumChannels() override { return m_numChannels; }
+    const std::vector<float>& getBinFrequencies() override { return m_binFrequencies; }
+
+    // A band transforms every few hops, and a fresh engine transforms every
+    // band on its first hop. The two agree only if every band's hop is a
+    // whole number of base hops that divides the longest window in hops.
+    bool canStartMidStream() override;
+    // Transforms the bands whose hop has elapsed and returns true if any did.
+    bool process(Ingress& ingress, int frameCount, uint64_t droppedFrames) override;
+
+    const std::vector<float>& getMagnitudes() override { return m_magnitudes; }
+
+private:
+    struct Band {
+        std::unique_ptr<FFT> fft;
+        int hopSize;
+        int framesSinceTransform;
+        int firstBin;
+        int numBins;
+        int outputOffset;
+        float gainDb;
+    };
+
+    const int m_numChannels;
+    int m_hopSize;
+    int m_longestWindow;
+    std::vector<Band> m_bands;
+    std::vector<float> m_binFrequencies;
+    std::vector<float> m_magnitudes;
+
+    void copyBand(Band& band);
+};
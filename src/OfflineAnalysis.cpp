@@ -0,0 +1,145 @@
+#include "OfflineAnalysis.hpp"
+
+#include <algorithm>
+
+OfflineAnalysis::OfflineAnalysis(
+    const AudioFile& file,
+    const std::function<std::unique_ptr<AnalysisEngine>()>& makeEngine,
+    int numThreads)
+    : m_file(file)
+    , m_numChannels(file.getNumChannels())
+{
+    m_engines.push_back(makeEngine());
+    m_hopSize = m_engines[0]->getHopSize();
+    m_frameSize = m_numChannels * m_engines[0]->getSpectrumSize();
+    bool parallel = m_engines[0]->canStartMidStream();
+    if (parallel) {
+        for (int i = 1; i < numThreads; i++) {
+            m_engines.push_back(makeEngine());
+        }
+    }
+
+    m_numHops = (file.getNumFrames() + m_hopSize - 1) / m_hopSize;
+    int windowHops = (m_engines[0]->getLongestWindow() + m_hopSize - 1) / m_hopSize;
+    m_preRollHops = parallel ? windowHops : 0;
+    int windowsPerSegment = (k_minSegmentHops + windowHops - 1) / windowHops;
+    if (windowsPerSegment < k_windowsPerSegment) {
+        windowsPerSegment = k_windowsPerSegment;
+    }
+    m_segmentHops = windowHops * windowsPerSegment;
+    m_numSegments = (m_numHops + m_segmentHops - 1) / m_segmentHops;
+
+    // Two spare buffers let threads run ahead while the reader is busy.
+    m_segments.resize(m_engines.size() + 2);
+    for (Segment& segment : m_segments) {
+        segment.magnitudes.resize(static_cast<size_t>(m_segmentHops) * m_frameSize);
+        segment.finished.resize(m_segmentHops);
+    }
+
+    for (std::unique_ptr<AnalysisEngine>& engine : m_engines) {
+        m_threads.push_back(std::thread(&OfflineAnalysis::work, this, engine.get()));
+    }
+}
+
+OfflineAnalysis::~OfflineAnalysis()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+const float* OfflineAnalysis::getHop(uint64_t hop)
+{
+    uint64_t index = hop / m_segmentHops;
+    Segment& segment = m_segments[index % m_segments.size()];
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (index > m_readSegment) {
+            m_readSegment = index;
+            m_changed.notify_all();
+        }
+        m_changed.wait(lock, [&] { return m_error || (segment.ready && segment.index == index); });
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+    int i = hop - index * m_segmentHops;
+    return segment.finished[i] ? &segment.magnitudes[static_cast<size_t>(i) * m_frameSize] : nullptr;
+}
+
+void OfflineAnalysis::work(AnalysisEngine* engine)
+{
+    // Here rather than a member, since it is over-aligned.
+    Ingress ingress(m_numChannels, std::max(engine->getLongestWindow(), m_hopSize));
+    std::vector<float> block(m_hopSize * m_numChannels);
+
+    while (true) {
+        uint64_t index;
+        Segment* segment;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stopping || m_nextSegment == m_numSegments) {
+                return;
+            }
+            index = m_nextSegment++;
+            segment = &m_segments[index % m_segments.size()];
+            m_changed.wait(lock, [&] { return m_stopping || index < m_readSegment + m_segments.size(); });
+            if (m_stopping) {
+                return;
+            }
+            segment->ready = false;
+        }
+
+        // An exception escaping a thread would terminate the process, so it
+        // is handed to the reader instead.
+        try {
+            analyzeSegment(*engine, ingress, block, index, *segment);
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+                m_stopping = true;
+            }
+            m_changed.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            segment->index = index;
+            segment->ready = true;
+        }
+        m_changed.notify_all();
+    }
+}
+
+void OfflineAnalysis::analyzeSegment(
+    AnalysisEngine& engine, Ingress& ingress, std::vector<float>& block, uint64_t index, Segment& segment)
+{
+    uint64_t firstHop = index * m_segmentHops;
+    uint64_t endHop = std::min(firstHop + m_segmentHops, m_numHops);
+    uint64_t startHop = firstHop - std::min<uint64_t>(firstHop, m_preRollHops);
+
+    for (uint64_t hop = startHop; hop < endHop; hop++) {
+        m_file.read(hop * m_hopSize, m_hopSize, block.data());
+        ingress.process(block.data(), nullptr, m_hopSize, 0, 0);
+        int frameCount = ingress.bufferSamples(m_hopSize);
+        bool finished = engine.process(ingress, frameCount, 0);
+        if (hop < firstHop) {
+            continue;
+        }
+        int i = hop - firstHop;
+        segment.finished[i] = finished;
+        if (finished) {
+            const std::vector<float>& magnitudes = engine.getMagnitudes();
+            std::copy(magnitudes.begin(), magnitudes.end(), segment.magnitudes.begin() + static_cast<size_t>(i) * m_frameSize);
+        }
+    }
+}
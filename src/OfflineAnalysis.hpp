@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AnalysisEngine.hpp"
+#include "AudioFile.hpp"
+
+// Runs an AnalysisEngine over a whole file on several threads, as fast as
+// they go, and hands the spectra back hop by hop, in order.
+//
+// The file is cut into segments of hops, and every thread takes the next
+// segment that is free, with an engine and Ingress of its own. Since an
+// FFT only sees the last window of audio, a thread primes its engine with
+// the stretch before the segment (the pre-roll) and its spectra come out as
+// if the file had been analyzed from the start. Segments and pre-rolls start
+// at multiples of the longest window, so multi-resolution bands whose hops
+// divide it keep the same phase of their hops as well. Engines that cannot
+// start mid-stream, including band layouts whose hops do not line up, run
+// on one thread, segment after segment.
+//
+// Finished segments wait in a ring of buffers until the reader is through
+// with them, so memory use does not depend on the length of the file.
+class OfflineAnalysis {
+public:
+    // makeEngine is called once per thread, here, since FFTW planning is not
+    // thread-safe. numThreads is a maximum.
+    OfflineAnalysis(
+        const AudioFile& file,
+        const std::function<std::unique_ptr<AnalysisEngine>()>& makeEngine,
+        int numThreads);
+    ~OfflineAnalysis();
+
+    OfflineAnalysis(const OfflineAnalysis& other) = delete;
+    OfflineAnalysis& operator=(const OfflineAnalysis& other) = delete;
+
+    // For its bin frequencies, hop size and frequency range, which every
+    // thread's engine shares.
+    AnalysisEngine& getEngine() { return *m_engines[0]; }
+    int getNumThreads() { return m_engines.size(); }
+    // Hop h covers frames [h * hop size, (h + 1) * hop size).
+    uint64_t getNumHops() { return m_numHops; }
+
+    // Waits for a hop and returns the [channel][bin] magnitudes in dB the
+    // engine finished at its end, or nullptr if it finished none there.
+    // Hops must be asked for in increasing order. The magnitudes stay valid
+    // until the next call. If a thread failed, rethrows what it threw.
+    const float* getHop(uint64_t hop);
+
+private:
+    struct Segment {
+        // Which segment of the file the buffer holds, once ready.
+        uint64_t index = 0;
+        bool ready = false;
+        std::vector<float> magnitudes;
+        std::vector<char> finished;
+    };
+
+    // Hops per segment as a multiple of the longest window.
+    static const int k_windowsPerSegment = 8;
+    static const int k_minSegmentHops = 256;
+
+    const AudioFile& m_file;
+    std::vector<std::unique_ptr<AnalysisEngine>> m_engines;
+    const int m_numChannels;
+    int m_hopSize;
+    int m_frameSize;
+    uint64_t m_numHops;
+    int m_preRollHops;
+    int m_segmentHops;
+    uint64_t m_numSegments;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<Segment> m_segments;
+    uint64_t m_nextSegment = 0;
+    // Every segment before this one has been read, so its buffer is free.
+    uint64_t m_readSegment = 0;
+    bool m_stopping = false;
+    // The first exception out of a thread, which stops the others.
+    std::exception_ptr m_error;
+    std::vector<std::thread> m_threads;
+
+    void work(AnalysisEngine* engine);
+    void analyzeSegment(AnalysisEngine& engine, Ingress& ingress, std::vector<float>& block, uint64_t index, Segment& segment);
+};
@@ -0,0 +1,284 @@
+#include "Options.hpp"
+#include "MultiResolutionFFT.hpp"
+#include "SlidingDFT.hpp"
+#include "ZoomFFT.hpp"
+
+static std::string nextArgument(int argc, char** argv, int& i)
+{
+    i++;
+    if (i >= argc) {
+        throw std::runtime_error("Unexpected end of arguments");
+    }
+    return argv[i];
+}
+
+static PlanEffort parsePlanEffort(const std::string& effort)
+{
+    if (effort == "estimate") {
+        return PlanEffort::Estimate;
+    } else if (effort == "measure") {
+        return PlanEffort::Measure;
+    } else if (effort == "patient") {
+        return PlanEffort::Patient;
+    }
+    throw std::runtime_error("Plan effort must be estimate, measure or patient");
+}
+
+// Parses "center:span" or "center:span:fftSize", in Hz.
+static void parseZoom(const std::string& zoom, Options& options)
+{
+    size_t first = zoom.find(':');
+    if (first == std::string::npos) {
+        throw std::runtime_error("Zoom must be center:span or center:span:fftSize");
+    }
+    size_t second = zoom.find(':', first + 1);
+    options.zoomCenter = std::stof(zoom.substr(0, first));
+    options.zoomSpan = std::stof(zoom.substr(first + 1, second - first - 1));
+    if (second != std::string::npos) {
+        options.zoomFFTSize = std::stoi(zoom.substr(second + 1));
+    }
+    if (options.zoomSpan <= 0 || options.zoomFFTSize < 2) {
+        throw std::runtime_error("Zoom span must be positive and its FFT size at least 2");
+    }
+}
+
+// Parses "widthxheight", in pixels.
+static void parseSize(const std::string& size, Options& options)
+{
+    size_t separator = size.find('x');
+    if (separator == std::string::npos) {
+        throw std::runtime_error("Size must be widthxheight");
+    }
+    options.width = std::stoi(size.substr(0, separator));
+    options.height = std::stoi(size.substr(separator + 1));
+    if (options.width < 1 || options.height < 1) {
+        throw std::runtime_error("Size must be at least 1x1");
+    }
+}
+
+// Parses "sampleRate:format", e.g. "48000:s16".
+static void parseRaw(const std::string& raw, Options& options)
+{
+    size_t separator = raw.find(':');
+    if (separator == std::string::npos) {
+        throw std::runtime_error("Raw audio must be described as sampleRate:format");
+    }
+    options.rawSampleRate = std::stof(raw.substr(0, separator));
+    options.rawFormat = parseSampleFormat(raw.substr(separator + 1));
+    if (options.rawSampleRate <= 0) {
+        throw std::runtime_error("Sample rate must be positive");
+    }
+}
+
+static TriggerEdge parseTriggerEdge(const std::string& edge)
+{
+    if (edge == "rising") {
+        return TriggerEdge::Rising;
+    } else if (edge == "falling") {
+        return TriggerEdge::Falling;
+    }
+    throw std::runtime_error("Trigger edge must be rising or falling");
+}
+
+Options parseOptions(int argc, char** argv, bool noDisplay)
+{
+    Options options;
+    options.noDisplay = noDisplay;
+
+    int i = 1;
+    while (i < argc) {
+        std::string arg = argv[i];
+        if (arg == "--device") {
+            options.device = nextArgument(argc, argv, i);
+        } else if (arg == "--channels") {
+            options.numChannels = std::stoi(nextArgument(argc, argv, i));
+            if (options.numChannels < 1) {
+                throw std::runtime_error("Need at least one channel");
+            }
+        } else if (arg == "--overlap") {
+            options.overlap = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--multires") {
+            options.bands = k_defaultMultiResolutionBands;
+        } else if (arg == "--bands") {
+            options.bands = nextArgument(argc, argv, i);
+        } else if (arg == "--plan-effort") {
+            options.planEffort = parsePlanEffort(nextArgument(argc, argv, i));
+        } else if (arg == "--zoom") {
+            parseZoom(nextArgument(argc, argv, i), options);
+        } else if (arg == "--sliding-dft") {
+            options.slidingDFT = true;
+        } else if (arg == "--bins-per-octave") {
+            options.binsPerOctave = std::stoi(nextArgument(argc, argv, i));
+        } else if (arg == "--cpu-curves") {
+            options.cpuCurves = true;
+        } else if (arg == "--waterfall") {
+            options.waterfallRows = std::stoi(nextArgument(argc, argv, i));
+            if (options.waterfallRows < 0) {
+                throw std::runtime_error("Waterfall history cannot be negative");
+            }
+        } else if (arg == "--persistence") {
+            options.persistence = std::stof(nextArgument(argc, argv, i));
+            if (options.persistence < 0) {
+                throw std::runtime_error("Persistence cannot be negative");
+            }
+        } else if (arg == "--peak-hold") {
+            options.accumulators.peakHold = true;
+            options.accumulators.peakHoldTime = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--peak-fall") {
+            options.accumulators.peakFallRate = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--min-hold") {
+            options.accumulators.minimumHold = true;
+        } else if (arg == "--average") {
+            options.accumulators.averageTime = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--window-average") {
+            options.accumulators.windowTime = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--waveform") {
+            options.waveformSpan = std::stof(nextArgument(argc, argv, i));
+            if (options.waveformSpan < 0) {
+                throw std::runtime_error("Waveform span cannot be negative");
+            }
+        } else if (arg == "--goniometer") {
+            options.goniometerPoints = std::stoi(nextArgument(argc, argv, i));
+            if (options.goniometerPoints < 0) {
+                throw std::runtime_error("Goniometer points cannot be negative");
+            }
+        } else if (arg == "--trigger") {
+            options.trigger = true;
+            options.triggerSettings.level = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--trigger-edge") {
+            options.triggerSettings.edge = parseTriggerEdge(nextArgument(argc, argv, i));
+        } else if (arg == "--trigger-channel") {
+            options.triggerSettings.channel = std::stoi(nextArgument(argc, argv, i)) - 1;
+        } else if (arg == "--trigger-hysteresis") {
+            options.triggerSettings.hysteresis = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--trigger-holdoff") {
+            options.triggerHoldoffSeconds = std::stof(nextArgument(argc, argv, i));
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--stats-file") {
+            options.statsFile = nextArgument(argc, argv, i);
+        } else if (arg == "--shm") {
+            options.shmName = nextArgument(argc, argv, i);
+            if (options.shmName.size() < 2 || options.shmName[0] != '/'
+                || options.shmName.find('/', 1) != std::string::npos) {
+                throw std::runtime_error("Shared memory names look like /name");
+            }
+        } else if (arg == "--size") {
+            parseSize(nextArgument(argc, argv, i), options);
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames") {
+            options.headlessFrames = std::stoi(nextArgument(argc, argv, i));
+            if (options.headlessFrames < 1) {
+                throw std::runtime_error("Need at least one frame");
+            }
+        } else if (arg == "--no-display") {
+            options.noDisplay = true;
+        } else if (arg == "--output") {
+            options.outputPath = nextArgument(argc, argv, i);
+        } else if (arg == "--interval") {
+            options.outputInterval = std::stof(nextArgument(argc, argv, i));
+            if (options.outputInterval <= 0) {
+                throw std::runtime_error("Output interval must be positive");
+            }
+        } else if (arg == "--cpu-budget") {
+            options.cpuBudget = std::stof(nextArgument(argc, argv, i));
+            if (options.cpuBudget < 0) {
+                throw std::runtime_error("CPU budget cannot be negative");
+            }
+        } else if (arg == "--soak") {
+            options.noDisplay = true;
+            options.soakSeconds = std::stof(nextArgument(argc, argv, i));
+            if (options.soakSeconds <= 0) {
+                throw std::runtime_error("Soak time must be positive");
+            }
+        } else if (arg == "--soak-speed") {
+            options.soakSpeed = std::stof(nextArgument(argc, argv, i));
+            if (options.soakSpeed <= 0) {
+                throw std::runtime_error("Soak speed must be positive");
+            }
+        } else if (arg == "--input") {
+            options.inputPath = nextArgument(argc, argv, i);
+        } else if (arg == "--raw") {
+            parseRaw(nextArgument(argc, argv, i), options);
+        } else if (arg == "--fps") {
+            options.frameRate = std::stof(nextArgument(argc, argv, i));
+            if (options.frameRate <= 0) {
+                throw std::runtime_error("Frame rate must be positive");
+            }
+        } else if (arg == "--images") {
+            options.imagePrefix = nextArgument(argc, argv, i);
+        } else if (arg == "--video") {
+            options.videoPath = nextArgument(argc, argv, i);
+        } else if (arg == "--threads") {
+            options.analysisThreads = std::stoi(nextArgument(argc, argv, i));
+            if (options.analysisThreads < 0) {
+                throw std::runtime_error("Thread count cannot be negative");
+            }
+        } else if (arg == "--prewarm") {
+            options.prewarm = true;
+        } else {
+            throw std::runtime_error("Unrecognized argument");
+        }
+        i++;
+    }
+
+    if (options.trigger && options.waveformSpan <= 0) {
+        throw std::runtime_error("--trigger needs --waveform");
+    }
+    if (!options.inputPath.empty() && (options.noDisplay || options.headless)) {
+        throw std::runtime_error("--input renders offscreen by itself, so it goes with neither --no-display nor --headless");
+    }
+    if (!options.inputPath.empty() && options.trigger) {
+        throw std::runtime_error("--trigger runs on live audio only, so it cannot go with --input");
+    }
+    if (options.inputPath.empty() && (!options.imagePrefix.empty() || !options.videoPath.empty())) {
+        throw std::runtime_error("--images and --video need --input");
+    }
+    if (options.noDisplay && options.headless) {
+        throw std::runtime_error("--headless renders, so it cannot go with --no-display");
+    }
+    // A soak test reports by itself at the end.
+    if (options.noDisplay && options.soakSeconds <= 0 && options.outputPath.empty() && options.shmName.empty()) {
+        throw std::runtime_error("--no-display needs --output or --shm");
+    }
+
+    return options;
+}
+
+std::unique_ptr<AnalysisEngine> makeAnalysisEngine(const Options& options, float sampleRate)
+{
+    if (options.zoomSpan > 0) {
+        return std::unique_ptr<AnalysisEngine>(new ZoomFFT(
+            options.zoomCenter,
+            options.zoomSpan,
+            options.zoomFFTSize,
+            options.numChannels,
+            sampleRate,
+            options.overlap,
+            k_analysisFFTSize,
+            options.planEffort));
+    }
+    if (options.slidingDFT) {
+        return std::unique_ptr<AnalysisEngine>(new SlidingDFT(
+            k_analysisFFTSize,
+            options.numChannels,
+            sampleRate,
+            SlidingDFT::k_defaultHopSize,
+            options.binsPerOctave,
+            k_analysisFFTSize));
+    }
+    std::vector<AnalysisBand> bands;
+    if (options.bands.empty()) {
+        bands.push_back({ k_analysisFFTSize, 0, sampleRate / 2 });
+    } else {
+        bands = parseAnalysisBands(options.bands, sampleRate);
+    }
+    return std::unique_ptr<AnalysisEngine>(new MultiResolutionFFT(
+        bands,
+        options.numChannels,
+        sampleRate,
+        options.overlap,
+        k_analysisFFTSize,
+        options.planEffort));
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "AnalysisEngine.hpp"
+#include "AudioFile.hpp"
+#include "FFT.hpp"
+#include "SpectrumAccumulators.hpp"
+#include "Trigger.hpp"
+
+// Used by --multires: fine resolution for the bass, coarse for the treble.
+static const char* const k_defaultMultiResolutionBands = "32768:200,4096:2500,512";
+
+struct Options {
+    std::string device = "system";
+    int numChannels = 2;
+    float overlap = 75;
+    // Empty for a single full-band FFT, else a band list for
+    // parseAnalysisBands().
+    std::string bands;
+    PlanEffort planEffort = PlanEffort::Measure;
+    bool prewarm = false;
+    // Zoom analysis of [zoomCenter - zoomSpan / 2, zoomCenter + zoomSpan / 2]
+    // when zoomSpan is nonzero.
+    float zoomCenter = 0;
+    float zoomSpan = 0;
+    int zoomFFTSize = 1024;
+    // Use a SlidingDFT updated every audio block instead of hopping FFTs.
+    bool slidingDFT = false;
+    int binsPerOctave = 48;
+    // Interpolate and extrude curves on the CPU even if the GPU could.
+    bool cpuCurves = false;
+    // Rows of spectrogram history shown under the curves, one per frame, or
+    // 0 for no waterfall.
+    int waterfallRows = 0;
+    // Time constant in seconds of the fading trail behind the curves, or 0
+    // for none.
+    float persistence = 0;
+    // Peak hold, minimum hold and average traces over the spectrum.
+    AccumulatorSettings accumulators;
+    // Seconds of audio shown by the waveform view, or 0 for none.
+    float waveformSpan = 0;
+    // L/R pairs plotted by the goniometer, or 0 for none.
+    int goniometerPoints = 0;
+    // Hold the waveform still on edges of one channel instead of scrolling.
+    bool trigger = false;
+    TriggerSettings triggerSettings;
+    float triggerHoldoffSeconds = 0;
+    // Show latency and timing stats in the window title, and write them as
+    // JSON to statsFile every second if it is not empty.
+    bool stats = false;
+    std::string statsFile;
+    // POSIX shared-memory name to publish every analysis frame under, or
+    // empty for none.
+    std::string shmName;
+    // Initial window size, or the framebuffer size when headless.
+    int width = 640;
+    int height = 480;
+    // Render offscreen from a synthetic signal instead of opening a window
+    // and an audio device, and report frame times after headlessFrames.
+    bool headless = false;
+    int headlessFrames = 600;
+    // Run the analysis without a window or OpenGL, writing frames every
+    // outputInterval seconds to outputPath ("-" for stdout) if it is not
+    // empty, and warning when the process uses more than cpuBudget percent
+    // of a core if that is nonzero.
+    bool noDisplay = false;
+    std::string outputPath;
+    float outputInterval = 1;
+    float cpuBudget = 0;
+    // With noDisplay, take synthetic input at soakSpeed times real time
+    // instead of an audio device, stop after soakSeconds, and report whether
+    // memory and CPU use stayed bounded.
+    float soakSeconds = 0;
+    float soakSpeed = 1;
+    // Analyze inputPath, a WAV file or, if rawSampleRate is nonzero, raw
+    // PCM with numChannels channels, and render it offscreen at frameRate
+    // to numbered PPM images named imagePrefix000000.ppm and on, and to
+    // videoPath as raw RGB frames ("-" for stdout), if they are not empty.
+    // Analysis runs on analysisThreads threads, or one per core if 0.
+    std::string inputPath;
+    float rawSampleRate = 0;
+    SampleFormat rawFormat = SampleFormat::Float32;
+    float frameRate = 60;
+    std::string imagePrefix;
+    std::string videoPath;
+    int analysisThreads = 0;
+};
+
+// noDisplay starts the options out as --no-display, for binaries that can
+// run no other way.
+Options parseOptions(int argc, char** argv, bool noDisplay = false);
+
+// FFT size of the single full-band analysis, and the size every engine
+// normalizes its levels to.
+static const int k_analysisFFTSize = 2048;
+
+// The analysis engine the options ask for: zoom, sliding DFT, or hopping
+// FFTs over one or more bands.
+std::unique_ptr<AnalysisEngine> makeAnalysisEngine(const Options& options, float sampleRate);
@@ -0,0 +1,114 @@
+#include "PersistenceBuffer.hpp"
+
+#include <cmath>
+
+static const char* k_vertexShaderSource = ("#version 140\n"
+                                           "out vec2 position;\n"
+                                           "void main()\n"
+                                           "{\n"
+                                           "    position = vec2(gl_VertexID % 2, gl_VertexID / 2);\n"
+                                           "    gl_Position = vec4(2.0 * position - 1.0, 0, 1);\n"
+                                           "}\n");
+
+static const char* k_fragmentShaderSource = ("#version 140\n"
+                                             "uniform sampler2D source;\n"
+                                             "uniform float decay;\n"
+                                             "uniform vec4 background;\n"
+                                             "in vec2 position;\n"
+                                             "out vec4 fragColor;\n"
+                                             "void main()\n"
+                                             "{\n"
+                                             "    fragColor = mix(background, texture(source, position), decay);\n"
+                                             "}\n");
+
+PersistenceBuffer::PersistenceBuffer(float timeConstant, float frameInterval, std::array<float, 4> background)
+    : m_timeConstant(timeConstant)
+    , m_background(background)
+{
+    setFrameInterval(frameInterval);
+    m_shaderProgram.reset(new ShaderProgram(k_vertexShaderSource, k_fragmentShaderSource));
+    m_program = m_shaderProgram->getProgram();
+    m_sourceLocation = glGetUniformLocation(m_program, "source");
+    m_decayLocation = glGetUniformLocation(m_program, "decay");
+    m_backgroundLocation = glGetUniformLocation(m_program, "background");
+
+    glGenVertexArrays(1, &m_vao);
+
+    glGenTextures(2, m_textures);
+    glGenFramebuffers(2, m_framebuffers);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+}
+
+PersistenceBuffer::~PersistenceBuffer()
+{
+    glDeleteFramebuffers(2, m_framebuffers);
+    glDeleteTextures(2, m_textures);
+    glDeleteVertexArrays(1, &m_vao);
+}
+
+bool PersistenceBuffer::isSupported()
+{
+    return GLEW_VERSION_3_1;
+}
+
+void PersistenceBuffer::setFrameInterval(float frameInterval)
+{
+    m_decay = std::exp(-frameInterval / m_timeConstant);
+}
+
+void PersistenceBuffer::resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[i], 0);
+        glClearBufferfv(GL_COLOR, 0, m_background.data());
+    }
+}
+
+void PersistenceBuffer::drawQuad(GLuint texture, float decay)
+{
+    glUseProgram(m_program);
+    glBindVertexArray(m_vao);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(m_sourceLocation, 0);
+    glUniform1f(m_decayLocation, decay);
+    glUniform4fv(m_backgroundLocation, 1, m_background.data());
+
+    // Replace, don't blend: the quad covers the whole target.
+    glDisable(GL_BLEND);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glEnable(GL_BLEND);
+    glBindVertexArray(0);
+}
+
+void PersistenceBuffer::begin(int width, int height)
+{
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+    if (width != m_width || height != m_height) {
+        resize(width, height);
+    }
+
+    int next = 1 - m_current;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[next]);
+    glViewport(0, 0, width, height);
+    drawQuad(m_textures[m_current], m_decay);
+    m_current = next;
+}
+
+void PersistenceBuffer::end(int x, int y)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_targetFramebuffer);
+    glViewport(x, y, m_width, m_height);
+    drawQuad(m_textures[m_current], 1);
+}
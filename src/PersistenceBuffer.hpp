@@ -0,0 +1,61 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <memory>
+
+#include "ShaderProgram.hpp"
+
+// Persistence of vision: a trail of recent frames that fades out. Instead
+// of redrawing the last N frames, drawing goes into an accumulation
+// texture. At the start of every frame, the previous accumulation is copied
+// into a second texture in one fullscreen pass, faded towards the
+// background by a decay factor. The two textures then swap roles. Cost is
+// the same however long the trail. Textures are RGBA32F: a long trail
+// fades by less than a half-float step per frame once it nears the
+// background, and would stop a few 8-bit steps above it. Needs OpenGL 3.1.
+class PersistenceBuffer {
+public:
+    // The trail fades by 1/e every timeConstant seconds, frames coming
+    // frameInterval seconds apart.
+    PersistenceBuffer(float timeConstant, float frameInterval, std::array<float, 4> background);
+    ~PersistenceBuffer();
+
+    PersistenceBuffer(const PersistenceBuffer& other) = delete;
+    PersistenceBuffer& operator=(const PersistenceBuffer& other) = delete;
+
+    static bool isSupported();
+
+    // For the frames from the next one on.
+    void setFrameInterval(float frameInterval);
+
+    // Fades the trail and redirects drawing into it, with a viewport of
+    // width by height pixels. Resizing clears the trail.
+    void begin(int width, int height);
+    // Draws the trail into the framebuffer that was bound at begin(), with
+    // its lower left corner at (x, y).
+    void end(int x, int y);
+
+private:
+    const float m_timeConstant;
+    // Fraction of the trail kept from one frame to the next.
+    float m_decay;
+    const std::array<float, 4> m_background;
+    int m_width = 0;
+    int m_height = 0;
+
+    GLuint m_textures[2];
+    GLuint m_framebuffers[2];
+    // Index of the texture holding the latest frame.
+    int m_current = 0;
+    GLint m_targetFramebuffer = 0;
+
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    GLuint m_program;
+    GLint m_sourceLocation;
+    GLint m_decayLocation;
+    GLint m_backgroundLocation;
+    GLuint m_vao;
+
+    void resize(int width, int height);
+    void drawQuad(GLuint texture, float decay);
+};
@@ -0,0 +1,36 @@
+#include "ProcessUsage.hpp"
+
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static double toSeconds(const timeval& time)
+{
+    return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+ProcessUsage ProcessUsage::measure()
+{
+    ProcessUsage usage;
+    rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0) {
+        usage.cpuSeconds = toSeconds(resources.ru_utime) + toSeconds(resources.ru_stime);
+#if (__APPLE__)
+        usage.residentBytes = resources.ru_maxrss;
+#else
+        usage.residentBytes = static_cast<uint64_t>(resources.ru_maxrss) * 1024;
+#endif
+    }
+
+    // The second field of statm is the resident set size in pages.
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm) {
+        unsigned long long size;
+        unsigned long long resident;
+        if (std::fscanf(statm, "%llu %llu", &size, &resident) == 2) {
+            usage.residentBytes = resident * sysconf(_SC_PAGESIZE);
+        }
+        std::fclose(statm);
+    }
+    return usage;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// CPU time and memory of this process, for keeping an eye on a process
+// that runs for weeks.
+struct ProcessUsage {
+    // User and system time of all threads so far.
+    double cpuSeconds = 0;
+    // Resident set size now. Where the system does not report it, the peak
+    // resident set size instead, which still shows growth.
+    uint64_t residentBytes = 0;
+
+    static ProcessUsage measure();
+};
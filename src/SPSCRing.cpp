@@ -0,0 +1,94 @@
+#include "SPSCRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static int nextPowerOfTwo(int n)
+{
+    int result = 1;
+    while (result < n) {
+        result *= 2;
+    }
+    return result;
+}
+
+SPSCRing::SPSCRing(int numChannels, int minimumCapacity)
+    : m_numChannels(numChannels)
+    , m_capacity(nextPowerOfTwo(minimumCapacity))
+    , m_mask(m_capacity - 1)
+    , m_data(new float[m_capacity * m_numChannels]())
+    , m_claimIndex(0)
+    , m_writeIndex(0)
+    , m_readIndex(0)
+{
+}
+
+void SPSCRing::write(const float* frames, int numFrames)
+{
+    uint64_t start = m_writeIndex.load(std::memory_order_relaxed);
+    uint64_t end = start + numFrames;
+
+    // Only the newest m_capacity frames of an oversized block can survive.
+    if (numFrames > m_capacity) {
+        frames += (numFrames - m_capacity) * m_numChannels;
+        start = end - m_capacity;
+        numFrames = m_capacity;
+    }
+
+    // Announce the overwrite before touching any slot, so a reader that
+    // copied from these slots can tell its copy may be torn.
+    m_claimIndex.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int offset = static_cast<int>(start & m_mask);
+    int firstPart = std::min(numFrames, m_capacity - offset);
+    std::memcpy(&m_data[offset * m_numChannels], frames, sizeof(float) * firstPart * m_numChannels);
+    std::memcpy(&m_data[0], frames + firstPart * m_numChannels, sizeof(float) * (numFrames - firstPart) * m_numChannels);
+
+    m_writeIndex.store(end, std::memory_order_release);
+}
+
+int SPSCRing::getReadAvailable()
+{
+    uint64_t available = m_writeIndex.load(std::memory_order_acquire) - m_readIndex;
+    return static_cast<int>(std::min<uint64_t>(available, m_capacity));
+}
+
+void SPSCRing::copyOut(uint64_t index, float* frames, int numFrames)
+{
+    int offset = static_cast<int>(index & m_mask);
+    int firstPart = std::min(numFrames, m_capacity - offset);
+    std::memcpy(frames, &m_data[offset * m_numChannels], sizeof(float) * firstPart * m_numChannels);
+    std::memcpy(frames + firstPart * m_numChannels, &m_data[0], sizeof(float) * (numFrames - firstPart) * m_numChannels);
+}
+
+int SPSCRing::read(float* frames, int maxFrames, uint64_t& droppedFrames)
+{
+    uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+    uint64_t readIndex = m_readIndex;
+    droppedFrames = 0;
+
+    // The producer lapped us; everything older than one ring is gone.
+    if (writeIndex - readIndex > static_cast<uint64_t>(m_capacity)) {
+        droppedFrames += writeIndex - readIndex - m_capacity;
+        readIndex = writeIndex - m_capacity;
+    }
+
+    int numFrames = static_cast<int>(std::min<uint64_t>(writeIndex - readIndex, maxFrames));
+    copyOut(readIndex, frames, numFrames);
+
+    // Any slot the producer has claimed since we loaded writeIndex may have
+    // been overwritten while we were copying it. Drop those frames.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t claimIndex = m_claimIndex.load(std::memory_order_relaxed);
+    if (claimIndex > readIndex + m_capacity) {
+        int overwritten = static_cast<int>(std::min<uint64_t>(claimIndex - m_capacity - readIndex, numFrames));
+        std::memmove(frames, frames + overwritten * m_numChannels, sizeof(float) * (numFrames - overwritten) * m_numChannels);
+        droppedFrames += overwritten;
+        readIndex += overwritten;
+        numFrames -= overwritten;
+    }
+
+    m_readIndex = readIndex + numFrames;
+    return numFrames;
+}
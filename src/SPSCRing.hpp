@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+static const int k_cacheLineSize = 64;
+
+// Single-producer single-consumer ring of interleaved float frames with
+// overwrite-oldest semantics. The producer never blocks and never touches
+// the consumer's index: it announces the range it is about to overwrite
+// through m_claimIndex, and the consumer discards whatever part of its read
+// was overwritten underneath it. Indices are 64-bit frame counters that
+// never wrap in practice.
+class SPSCRing {
+public:
+    SPSCRing(int numChannels, int minimumCapacity);
+
+    SPSCRing(const SPSCRing& other) = delete;
+    SPSCRing& operator=(const SPSCRing& other) = delete;
+
+    int getCapacity() { return m_capacity; }
+
+    // Producer side. Wait-free and allocation-free.
+    void write(const float* frames, int numFrames);
+
+    // Consumer side. Frames that were overwritten before they could be read
+    // are skipped and added to droppedFrames.
+    int getReadAvailable();
+    int read(float* frames, int maxFrames, uint64_t& droppedFrames);
+
+private:
+    const int m_numChannels;
+    const int m_capacity;
+    const uint64_t m_mask;
+    std::unique_ptr<float[]> m_data;
+
+    // Written by the producer only.
+    alignas(k_cacheLineSize) std::atomic<uint64_t> m_claimIndex;
+    std::atomic<uint64_t> m_writeIndex;
+
+    // Written by the consumer only.
+    alignas(k_cacheLineSize) uint64_t m_readIndex;
+
+    void copyOut(uint64_t index, float* frames, int numFrames);
+};
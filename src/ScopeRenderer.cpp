@@ -0,0 +1,304 @@
+#include "ScopeRenderer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+// One instance per layer. Row gl_InstanceID of the chunks texture holds the
+// layer's (x, dB) control points, and of the layers texture its color and
+// its (thickness in pixels, filled, number of chunks, cubic resolution).
+// Plot point i lies a fraction (i mod cubicResolution) / cubicResolution
+// of the way from chunk i / cubicResolution to the next, exactly as in
+// Spectrum::update(). Vertices 2i and 2i + 1 are the two sides of the
+// stroke at that point, or the curve and the bottom of the screen when
+// filled. Layers with fewer points repeat their last one, which only adds
+// degenerate triangles.
+static const char* k_gpuVertexShaderSource = ("#version 140\n"
+                                              "uniform sampler2D chunks;\n"
+                                              "uniform sampler2D layers;\n"
+                                              "uniform vec2 range;\n"
+                                              "uniform vec2 windowSize;\n"
+                                              "flat out vec4 layerColor;\n"
+                                              "int numChunks;\n"
+                                              "vec2 chunk(int i)\n"
+                                              "{\n"
+                                              "    return texelFetch(chunks, ivec2(clamp(i, 0, numChunks - 1), gl_InstanceID), 0).rg;\n"
+                                              "}\n"
+                                              "void main()\n"
+                                              "{\n"
+                                              "    layerColor = texelFetch(layers, ivec2(0, gl_InstanceID), 0);\n"
+                                              "    vec4 style = texelFetch(layers, ivec2(1, gl_InstanceID), 0);\n"
+                                              "    numChunks = int(style.z);\n"
+                                              "    int cubicResolution = int(style.w);\n"
+                                              "    if (numChunks == 0) {\n"
+                                              "        gl_Position = vec4(0, 0, 0, 1);\n"
+                                              "        return;\n"
+                                              "    }\n"
+                                              "    int point = min(gl_VertexID / 2, numChunks * cubicResolution - 1);\n"
+                                              "    int t1 = point / cubicResolution;\n"
+                                              "    float t = float(point - t1 * cubicResolution) / float(cubicResolution);\n"
+                                              "    vec2 p0 = chunk(t1 - 1);\n"
+                                              "    vec2 p1 = chunk(t1);\n"
+                                              "    vec2 p2 = chunk(t1 + 1);\n"
+                                              "    vec2 p3 = chunk(t1 + 2);\n"
+                                              "    vec2 a = -p0 + 3.0 * p1 - 3.0 * p2 + p3;\n"
+                                              "    vec2 b = 2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3;\n"
+                                              "    vec2 c = -p0 + p2;\n"
+                                              "    vec2 p = 0.5 * (((a * t + b) * t + c) * t + 2.0 * p1);\n"
+                                              "    vec2 screen = vec2(2.0 * p.x - 1.0, 2.0 * (p.y - range.x) / (range.y - range.x) - 1.0);\n"
+                                              "    bool lower = gl_VertexID % 2 == 1;\n"
+                                              "    if (style.y > 0.5) {\n"
+                                              "        gl_Position = vec4(screen.x, lower ? -1.0 : screen.y, 1, 1);\n"
+                                              "        return;\n"
+                                              "    }\n"
+                                              "    vec2 d = 0.5 * ((3.0 * a * t + 2.0 * b) * t + c);\n"
+                                              "    vec2 normal = vec2(d.y / (range.y - range.x), d.x);\n"
+                                              "    float magnitude = length(normal);\n"
+                                              "    normal = magnitude > 0.0 ? normal / magnitude : vec2(0, 1);\n"
+                                              "    vec2 offset = vec2(-normal.x, normal.y) * style.x / windowSize * 0.5;\n"
+                                              "    gl_Position = vec4(lower ? screen - offset : screen + offset, 1, 1);\n"
+                                              "}\n");
+
+static const char* k_gpuFragmentShaderSource = ("#version 140\n"
+                                                "flat in vec4 layerColor;\n"
+                                                "out vec4 fragColor;\n"
+                                                "void main()\n"
+                                                "{\n"
+                                                "    fragColor = layerColor;\n"
+                                                "}\n");
+
+static const char* k_cpuVertexShaderSource = ("#version 120\n"
+                                              "attribute vec2 pos;\n"
+                                              "attribute vec4 color;\n"
+                                              "varying vec4 vertexColor;\n"
+                                              "void main()\n"
+                                              "{\n"
+                                              "    vertexColor = color;\n"
+                                              "    gl_Position = vec4(pos, 1, 1);\n"
+                                              "}\n");
+
+static const char* k_cpuFragmentShaderSource = ("#version 120\n"
+                                                "varying vec4 vertexColor;\n"
+                                                "void main()\n"
+                                                "{\n"
+                                                "    gl_FragColor = vertexColor;\n"
+                                                "}\n");
+
+static void setNearestFiltering()
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+ScopeRenderer::ScopeRenderer(bool gpuCurves)
+    : m_gpuCurves(gpuCurves)
+{
+    if (m_gpuCurves) {
+        m_shaderProgram.reset(new ShaderProgram(k_gpuVertexShaderSource, k_gpuFragmentShaderSource));
+    } else {
+        m_shaderProgram.reset(new ShaderProgram(k_cpuVertexShaderSource, k_cpuFragmentShaderSource));
+    }
+    m_program = m_shaderProgram->getProgram();
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+
+    if (m_gpuCurves) {
+        m_chunksLocation = glGetUniformLocation(m_program, "chunks");
+        m_layersLocation = glGetUniformLocation(m_program, "layers");
+        m_rangeLocation = glGetUniformLocation(m_program, "range");
+        m_windowSizeLocation = glGetUniformLocation(m_program, "windowSize");
+
+        glGenTextures(1, &m_chunkTexture);
+        glBindTexture(GL_TEXTURE_2D, m_chunkTexture);
+        setNearestFiltering();
+        glGenTextures(1, &m_layerTexture);
+        glBindTexture(GL_TEXTURE_2D, m_layerTexture);
+        setNearestFiltering();
+    } else {
+        glGenBuffers(1, &m_vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        GLint pos = m_shaderProgram->getAttribLocation("pos");
+        GLint color = m_shaderProgram->getAttribLocation("color");
+        glVertexAttribPointer(pos, 2, GL_FLOAT, GL_FALSE, sizeof(CurveVertex), (void*)offsetof(CurveVertex, x));
+        glEnableVertexAttribArray(pos);
+        glVertexAttribPointer(color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CurveVertex), (void*)offsetof(CurveVertex, color));
+        glEnableVertexAttribArray(color);
+
+        glGenBuffers(1, &m_ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    }
+
+    glBindVertexArray(0);
+}
+
+ScopeRenderer::~ScopeRenderer()
+{
+    if (m_gpuCurves) {
+        glDeleteTextures(1, &m_chunkTexture);
+        glDeleteTextures(1, &m_layerTexture);
+    } else {
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_ebo);
+    }
+    glDeleteVertexArrays(1, &m_vao);
+}
+
+bool ScopeRenderer::supportsGPUCurves()
+{
+    return GLEW_VERSION_3_1;
+}
+
+void ScopeRenderer::addLayer(Spectrum& spectrum, std::array<float, 4> color, float thicknessInPixels, bool filled)
+{
+    m_layers.push_back({ &spectrum, color, thicknessInPixels, filled, 0 });
+    m_layoutChanged = true;
+}
+
+// Resizes the shared buffers if a layer was added or a Spectrum changed its
+// number of points since the last render. Returns true if it did.
+bool ScopeRenderer::updateLayout()
+{
+    for (Layer& layer : m_layers) {
+        int size = m_gpuCurves
+            ? layer.spectrum->getChunkY().size()
+            : layer.spectrum->getNumPlotPoints();
+        if (size != layer.size) {
+            layer.size = size;
+            m_layoutChanged = true;
+        }
+    }
+    if (!m_layoutChanged) {
+        return false;
+    }
+    m_layoutChanged = false;
+
+    int numLayers = m_layers.size();
+    if (m_gpuCurves) {
+        int maxChunks = 1;
+        m_maxPlotPoints = 0;
+        std::vector<float> styles(8 * numLayers);
+        for (int i = 0; i < numLayers; i++) {
+            const Layer& layer = m_layers[i];
+            int cubicResolution = layer.spectrum->getCubicResolution();
+            maxChunks = std::max(maxChunks, layer.size);
+            m_maxPlotPoints = std::max(m_maxPlotPoints, layer.size * cubicResolution);
+            std::copy(layer.color.begin(), layer.color.end(), &styles[8 * i]);
+            styles[8 * i + 4] = layer.thicknessInPixels;
+            styles[8 * i + 5] = layer.filled;
+            styles[8 * i + 6] = layer.size;
+            styles[8 * i + 7] = cubicResolution;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_layerTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 2, numLayers, 0, GL_RGBA, GL_FLOAT, styles.data());
+
+        if (maxChunks > m_chunkTextureWidth || numLayers > m_chunkTextureHeight) {
+            m_chunkTextureWidth = std::max(m_chunkTextureWidth, maxChunks);
+            m_chunkTextureHeight = std::max(m_chunkTextureHeight, numLayers);
+            glBindTexture(GL_TEXTURE_2D, m_chunkTexture);
+            glTexImage2D(
+                GL_TEXTURE_2D, 0, GL_RG32F, m_chunkTextureWidth, m_chunkTextureHeight, 0, GL_RG, GL_FLOAT, nullptr);
+            m_chunks.resize(2 * m_chunkTextureWidth * m_chunkTextureHeight);
+        }
+        return true;
+    }
+
+    // Two vertices per plot point, two triangles between consecutive ones.
+    // The index buffer only grows, so a resize that gives fewer points just
+    // overwrites the start of it.
+    m_elements.clear();
+    int numVertices = 0;
+    for (const Layer& layer : m_layers) {
+        for (int i = 0; i < layer.size - 1; i++) {
+            GLuint first = numVertices + 2 * i;
+            m_elements.push_back(first + 0);
+            m_elements.push_back(first + 1);
+            m_elements.push_back(first + 2);
+            m_elements.push_back(first + 1);
+            m_elements.push_back(first + 2);
+            m_elements.push_back(first + 3);
+        }
+        numVertices += 2 * layer.size;
+    }
+    m_vertices.resize(numVertices);
+    m_numElements = m_elements.size();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    if (m_numElements > m_elementCapacity) {
+        m_elementCapacity = m_numElements;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_numElements * sizeof(GLuint), m_elements.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_numElements * sizeof(GLuint), m_elements.data());
+    }
+    return true;
+}
+
+void ScopeRenderer::render(RangeComputer& rangeComputer, int width, int height)
+{
+    if (m_layers.empty()) {
+        return;
+    }
+
+    glUseProgram(m_program);
+    glBindVertexArray(m_vao);
+    updateLayout();
+
+    if (m_gpuCurves) {
+        renderGPUCurves(rangeComputer, width, height);
+    } else {
+        renderCPUCurves(rangeComputer, width, height);
+    }
+
+    glBindVertexArray(0);
+}
+
+void ScopeRenderer::renderGPUCurves(RangeComputer& rangeComputer, int width, int height)
+{
+    int numLayers = m_layers.size();
+    for (int i = 0; i < numLayers; i++) {
+        const std::vector<float>& chunkX = m_layers[i].spectrum->getChunkX();
+        const std::vector<float>& chunkY = m_layers[i].spectrum->getChunkY();
+        float* row = &m_chunks[2 * m_chunkTextureWidth * i];
+        for (int j = 0; j < m_layers[i].size; j++) {
+            row[2 * j] = chunkX[j];
+            row[2 * j + 1] = chunkY[j];
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_chunkTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_chunkTextureWidth, numLayers, GL_RG, GL_FLOAT, m_chunks.data());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_layerTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(m_chunksLocation, 0);
+    glUniform1i(m_layersLocation, 1);
+    glUniform2f(m_rangeLocation, rangeComputer.getBottom(), rangeComputer.getTop());
+    glUniform2f(m_windowSizeLocation, width, height);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 2 * m_maxPlotPoints, numLayers);
+}
+
+void ScopeRenderer::renderCPUCurves(RangeComputer& rangeComputer, int width, int height)
+{
+    CurveVertex* vertices = m_vertices.data();
+    for (const Layer& layer : m_layers) {
+        if (layer.filled) {
+            fillCurve(*layer.spectrum, rangeComputer, layer.color, vertices);
+        } else {
+            strokeCurve(
+                *layer.spectrum, rangeComputer, layer.color, layer.thicknessInPixels,
+                width, height, vertices);
+        }
+        vertices += 2 * layer.size;
+    }
+
+    // Respecifying the whole store lets the driver hand out fresh memory
+    // instead of waiting for the previous frame's draw to finish with it.
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(CurveVertex), m_vertices.data(), GL_STREAM_DRAW);
+
+    glDrawElements(GL_TRIANGLES, m_numElements, GL_UNSIGNED_INT, (void*)0);
+}
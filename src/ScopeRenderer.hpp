@@ -0,0 +1,82 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "CurveGeometry.hpp"
+#include "FFT.hpp"
+#include "ShaderProgram.hpp"
+#include "Spectrum.hpp"
+
+// Draws every spectrum layer in one pass with one shared program. Layers
+// are drawn in the order they were added, each as a stroked curve or as
+// the area under a curve.
+//
+// With OpenGL 3.1, only the Spectrums' chunk control points are uploaded,
+// as one row per layer of an RG32F texture, and a single instanced draw
+// evaluates the Catmull-Rom curves, normals and stroke extrusion in the
+// vertex shader (one instance per layer). Otherwise the curves are
+// extruded on the CPU into one streaming vertex buffer of positions and
+// colors, and drawn by a single glDrawElements over a shared index buffer.
+class ScopeRenderer {
+public:
+    explicit ScopeRenderer(bool gpuCurves);
+    ~ScopeRenderer();
+
+    ScopeRenderer(const ScopeRenderer& other) = delete;
+    ScopeRenderer& operator=(const ScopeRenderer& other) = delete;
+
+    static bool supportsGPUCurves();
+    // When true, Spectrums only need updateChunks() before render().
+    bool usesGPUCurves() { return m_gpuCurves; }
+
+    // The spectrum must outlive the renderer.
+    void addLayer(Spectrum& spectrum, std::array<float, 4> color, float thicknessInPixels, bool filled);
+
+    // Draws into the current viewport, which is width by height pixels.
+    void render(RangeComputer& rangeComputer, int width, int height);
+
+private:
+    struct Layer {
+        Spectrum* spectrum;
+        std::array<float, 4> color;
+        float thicknessInPixels;
+        bool filled;
+        // Plot points (CPU) or chunks (GPU) at the last render, to notice
+        // a resized Spectrum.
+        int size;
+    };
+
+    const bool m_gpuCurves;
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    GLuint m_program;
+    std::vector<Layer> m_layers;
+    bool m_layoutChanged = true;
+
+    GLuint m_vao;
+
+    // GPU path.
+    GLint m_chunksLocation;
+    GLint m_layersLocation;
+    GLint m_rangeLocation;
+    GLint m_windowSizeLocation;
+    GLuint m_chunkTexture;
+    GLuint m_layerTexture;
+    int m_chunkTextureWidth = 0;
+    int m_chunkTextureHeight = 0;
+    std::vector<float> m_chunks;
+    int m_maxPlotPoints = 0;
+
+    // CPU path.
+    GLuint m_vbo;
+    GLuint m_ebo;
+    std::vector<CurveVertex> m_vertices;
+    std::vector<GLuint> m_elements;
+    int m_numElements = 0;
+    int m_elementCapacity = 0;
+
+    bool updateLayout();
+    void renderGPUCurves(RangeComputer& rangeComputer, int width, int height);
+    void renderCPUCurves(RangeComputer& rangeComputer, int width, int height);
+};
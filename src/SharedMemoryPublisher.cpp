@@ -0,0 +1,165 @@
+#include "SharedMemoryPublisher.hpp"
+#include "Clock.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+// The process that created the object under name, or 0 if it has none or
+// its header cannot be read, e.g. because it is still being set up.
+static pid_t findProducer(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    pid_t producer = 0;
+    struct stat status;
+    if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(nicescope_shm_header)) {
+        void* memory = mmap(nullptr, sizeof(nicescope_shm_header), PROT_READ, MAP_SHARED, fd, 0);
+        if (memory != MAP_FAILED) {
+            const nicescope_shm_header* header = static_cast<const nicescope_shm_header*>(memory);
+            if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == NICESCOPE_SHM_MAGIC) {
+                producer = header->producer_pid;
+            }
+            munmap(memory, sizeof(nicescope_shm_header));
+        }
+    }
+    close(fd);
+    return producer;
+}
+
+SharedMemoryPublisher::SharedMemoryPublisher(
+    const std::string& name,
+    const std::vector<float>& binFrequencies,
+    int numChannels,
+    float sampleRate,
+    float lowestFrequency,
+    float highestFrequency)
+    : m_name(name)
+    , m_numChannels(numChannels)
+    , m_spectrumSize(binFrequencies.size())
+    // No smoothing: readers get each frame's own levels.
+    , m_chunker(binFrequencies, 2, 0, 0)
+{
+    m_chunker.setFrequencyRange(lowestFrequency, highestFrequency);
+    m_chunker.setWindowSize(k_chunkWidth, 1);
+    int maxChunks = m_chunker.getChunkX().size();
+
+    nicescope_shm_header layout;
+    std::memset(&layout, 0, sizeof(layout));
+    layout.version = NICESCOPE_SHM_VERSION;
+    layout.header_size = sizeof(nicescope_shm_header);
+    layout.num_slots = k_numSlots;
+    layout.bin_frequencies_offset = NICESCOPE_SHM_ALIGN(sizeof(nicescope_shm_header));
+    layout.slots_offset = layout.bin_frequencies_offset + NICESCOPE_SHM_ALIGN(m_spectrumSize * sizeof(float));
+    layout.num_channels = numChannels;
+    layout.spectrum_size = m_spectrumSize;
+    layout.max_chunks = maxChunks;
+    layout.slot_size = nicescope_shm_chunks_offset(&layout) + NICESCOPE_SHM_ALIGN(2 * maxChunks * sizeof(float));
+    layout.total_size = layout.slots_offset + k_numSlots * layout.slot_size;
+    layout.sample_rate = sampleRate;
+    layout.producer_pid = getpid();
+    m_size = layout.total_size;
+
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        // Replace an object a crashed run left behind, so readers never
+        // attach to a stale layout, but never one a running producer owns.
+        pid_t owner = findProducer(m_name);
+        if (owner > 0 && kill(owner, 0) != 0 && errno == ESRCH) {
+            shm_unlink(m_name.c_str());
+            fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        } else {
+            throw std::runtime_error(owner > 0
+                    ? "Shared memory " + m_name + " is in use by process " + std::to_string(owner)
+                    : "Shared memory " + m_name + " already exists and is not a NiceScope feed");
+        }
+    }
+    if (fd < 0) {
+        throw std::runtime_error("Could not create shared memory " + m_name + ": " + std::strerror(errno));
+    }
+    struct stat status;
+    fstat(fd, &status);
+    m_device = status.st_dev;
+    m_inode = status.st_ino;
+    if (ftruncate(fd, m_size) != 0) {
+        close(fd);
+        shm_unlink(m_name.c_str());
+        throw std::runtime_error("Could not size shared memory " + m_name);
+    }
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(m_name.c_str());
+        throw std::runtime_error("Could not map shared memory " + m_name);
+    }
+
+    // ftruncate() zeroed everything, so every slot starts unlocked and
+    // empty. The magic number goes in last.
+    m_header = static_cast<nicescope_shm_header*>(memory);
+    std::memcpy(m_header, &layout, sizeof(layout));
+    float* frequencies = reinterpret_cast<float*>(static_cast<char*>(memory) + layout.bin_frequencies_offset);
+    std::copy(binFrequencies.begin(), binFrequencies.end(), frequencies);
+    __atomic_store_n(&m_header->magic, NICESCOPE_SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher()
+{
+    munmap(m_header, m_size);
+    // Leave the name alone if it has been given to another object since.
+    int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+    struct stat status;
+    bool isOurs = fstat(fd, &status) == 0 && status.st_dev == m_device && status.st_ino == m_inode;
+    close(fd);
+    if (isOurs) {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+void SharedMemoryPublisher::publish(const AnalysisFrame& frame)
+{
+    m_chunker.updateChunks(frame.maximumSpectrum.data());
+    const std::vector<float>& chunkX = m_chunker.getChunkX();
+    const std::vector<float>& chunkY = m_chunker.getChunkY();
+
+    // Readers compare these times with their own CLOCK_MONOTONIC, which
+    // steady_clock is not promised to be, so the ADC time is moved across
+    // by the offset between the two clocks read back to back.
+    timespec monotonic;
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    double publishTime = monotonic.tv_sec + monotonic.tv_nsec * 1e-9;
+    double adcTime = frame.newestSampleTime + (publishTime - getSteadyTime());
+
+    m_sequence++;
+    nicescope_shm_slot* slot = const_cast<nicescope_shm_slot*>(nicescope_shm_slot_at(m_header, m_sequence));
+    char* base = reinterpret_cast<char*>(slot);
+
+    uint64_t lock = slot->lock;
+    __atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->sequence = m_sequence;
+    slot->adc_time = adcTime;
+    slot->publish_time = publishTime;
+    slot->wall_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->maximum = frame.maximum;
+    slot->num_chunks = chunkX.size();
+    std::copy(
+        frame.magnitudes.begin(),
+        frame.magnitudes.begin() + m_numChannels * m_spectrumSize,
+        reinterpret_cast<float*>(base + nicescope_shm_magnitudes_offset()));
+    float* chunks = reinterpret_cast<float*>(base + nicescope_shm_chunks_offset(m_header));
+    std::copy(chunkX.begin(), chunkX.end(), chunks);
+    std::copy(chunkY.begin(), chunkY.end(), chunks + m_header->max_chunks);
+
+    __atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&m_header->latest_sequence, m_sequence, __ATOMIC_RELEASE);
+}
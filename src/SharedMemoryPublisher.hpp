@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Analyzer.hpp"
+#include "Spectrum.hpp"
+#include "nicescope_shm.h"
+
+// Writes every analysis frame into a POSIX shared-memory object that other
+// processes can map and read in place; include/nicescope_shm.h describes
+// the layout and has the reader side. Each frame goes into the next slot
+// of a ring under that slot's seqlock, so publishing is a few copies into
+// mapped memory and never waits for a reader. An object left by a producer
+// that has exited is replaced, but one whose producer is still running is
+// not. The object is removed when the publisher is destroyed.
+class SharedMemoryPublisher {
+public:
+    // name is a POSIX shared-memory name, like "/nicescope". Frequencies
+    // outside [lowestFrequency, highestFrequency] are left out of the
+    // chunks, as they are from the display.
+    SharedMemoryPublisher(
+        const std::string& name,
+        const std::vector<float>& binFrequencies,
+        int numChannels,
+        float sampleRate,
+        float lowestFrequency,
+        float highestFrequency);
+    ~SharedMemoryPublisher();
+
+    SharedMemoryPublisher(const SharedMemoryPublisher& other) = delete;
+    SharedMemoryPublisher& operator=(const SharedMemoryPublisher& other) = delete;
+
+    // Analysis thread.
+    void publish(const AnalysisFrame& frame);
+
+private:
+    static const int k_numSlots = 8;
+    // Width in pixels of the plot the chunks are made for.
+    static const int k_chunkWidth = 1024;
+
+    const std::string m_name;
+    const int m_numChannels;
+    const int m_spectrumSize;
+    Spectrum m_chunker;
+    size_t m_size;
+    // Which object this is, so that destruction never removes another
+    // producer's object that took over the name.
+    dev_t m_device;
+    ino_t m_inode;
+    nicescope_shm_header* m_header;
+    uint64_t m_sequence = 0;
+};
@@ -0,0 +1,593 @@
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+static const float k_minimumPower = 1e-30f;
+static const float k_dbPerOctave = 3.01029995664f; // 10 * log10(2)
+
+// Degree 5 polynomial for log2(m), m in [1, 2), in powers of (m - 1).
+// Interpolated at Chebyshev nodes; maximum error 1.7e-5.
+static const float k_log2Coefficients[6] = {
+    1.65146709e-05f,
+    1.44149241f,
+    -0.706486449f,
+    0.409470299f,
+    -0.187488605f,
+    0.0430049578f,
+};
+
+// Odd polynomial for atan(z), z in [-1, 1], in powers of z^2. Maximum
+// error 1e-7.
+static const float k_atanCoefficients[6] = {
+    0.99997726f,
+    -0.33262347f,
+    0.19354346f,
+    -0.11643287f,
+    0.05265332f,
+    -0.01172120f,
+};
+
+// Degree 5 polynomial for 2^f, f in [0, 1). Interpolated at Chebyshev
+// nodes; maximum relative error 1.1e-7.
+static const float k_exp2Coefficients[6] = {
+    0.999999898f,
+    0.69315449f,
+    0.240141818f,
+    0.0558603371f,
+    0.00894959042f,
+    0.00189375406f,
+};
+
+static const float k_pi = 3.14159265358979f;
+static const float k_octavesPerDb = 0.332192809f; // log2(10) / 10
+
+static inline float fastLog2(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+    float t = mantissa - 1;
+    const float* c = k_log2Coefficients;
+    return exponent + (c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5])))));
+}
+
+static inline float fastExp2(float x)
+{
+    // Clamped to the range of normal floats.
+    x = std::min(std::max(x, -126.0f), 127.0f);
+    float whole = std::floor(x);
+    float t = x - whole;
+    const float* c = k_exp2Coefficients;
+    float p = c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5]))));
+    uint32_t bits = static_cast<uint32_t>(static_cast<int>(whole) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+#if defined(__SSE2__)
+static inline __m128 fastExp2(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126)), _mm_set1_ps(127));
+    // Truncation rounds negative values up; take one off to floor them.
+    __m128i whole = _mm_cvttps_epi32(x);
+    __m128 wholeFloat = _mm_cvtepi32_ps(whole);
+    __m128i roundedUp = _mm_castps_si128(_mm_cmpgt_ps(wholeFloat, x));
+    whole = _mm_add_epi32(whole, roundedUp);
+    __m128 t = _mm_sub_ps(x, _mm_cvtepi32_ps(whole));
+    const float* c = k_exp2Coefficients;
+    __m128 p = _mm_set1_ps(c[5]);
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[4]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[3]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[2]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[1]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[0]));
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+#endif
+
+#if defined(__AVX2__)
+static inline __m256 fmadd(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+static inline __m256 fastLog2(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 exponent = _mm256_cvtepi32_ps(
+        _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+        _mm256_set1_epi32(0x3f800000)));
+    __m256 t = _mm256_sub_ps(mantissa, _mm256_set1_ps(1));
+    const float* c = k_log2Coefficients;
+    __m256 p = _mm256_set1_ps(c[5]);
+    p = fmadd(p, t, _mm256_set1_ps(c[4]));
+    p = fmadd(p, t, _mm256_set1_ps(c[3]));
+    p = fmadd(p, t, _mm256_set1_ps(c[2]));
+    p = fmadd(p, t, _mm256_set1_ps(c[1]));
+    p = fmadd(p, t, _mm256_set1_ps(c[0]));
+    return _mm256_add_ps(exponent, p);
+}
+#endif
+
+#if defined(__SSE2__)
+static inline __m128 fastLog2(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128 exponent = _mm_cvtepi32_ps(
+        _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+        _mm_set1_epi32(0x3f800000)));
+    __m128 t = _mm_sub_ps(mantissa, _mm_set1_ps(1));
+    const float* c = k_log2Coefficients;
+    __m128 p = _mm_set1_ps(c[5]);
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[4]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[3]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[2]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[1]));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(c[0]));
+    return _mm_add_ps(exponent, p);
+}
+#endif
+
+static void deinterleaveStereo(
+    const float* interleaved, int numFrames, float* left, float* right, float* leftMirror, float* rightMirror)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= numFrames; i += 4) {
+        __m128 a = _mm_loadu_ps(interleaved + 2 * i);
+        __m128 b = _mm_loadu_ps(interleaved + 2 * i + 4);
+        __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(left + i, l);
+        _mm_storeu_ps(leftMirror + i, l);
+        _mm_storeu_ps(right + i, r);
+        _mm_storeu_ps(rightMirror + i, r);
+    }
+#endif
+    for (; i < numFrames; i++) {
+        left[i] = leftMirror[i] = interleaved[2 * i];
+        right[i] = rightMirror[i] = interleaved[2 * i + 1];
+    }
+}
+
+#if defined(__SSE2__)
+// Transposes blocks of four frames by four channels and returns how many
+// frames it did. When numChannels is not a multiple of four the last group
+// overlaps the one before, writing some channels twice with the same
+// values. With three channels every load takes one sample of the next
+// frame, so the last frame is left to the caller.
+static int deinterleaveBlocks(
+    const float* interleaved,
+    int numChannels,
+    int numFrames,
+    float* const* destinations,
+    float* const* mirrorDestinations)
+{
+    int end = numChannels >= 4 ? numFrames : numFrames - 1;
+    int width = std::min(numChannels, 4);
+    int i = 0;
+    for (; i + 4 <= end; i += 4) {
+        const float* frames = interleaved + i * numChannels;
+        for (int group = 0; group < numChannels; group += 4) {
+            int first = std::max(0, std::min(group, numChannels - 4));
+            __m128 rows[4];
+            for (int frame = 0; frame < 4; frame++) {
+                rows[frame] = _mm_loadu_ps(frames + frame * numChannels + first);
+            }
+            _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+            for (int channel = 0; channel < width; channel++) {
+                _mm_storeu_ps(destinations[first + channel] + i, rows[channel]);
+                _mm_storeu_ps(mirrorDestinations[first + channel] + i, rows[channel]);
+            }
+        }
+    }
+    return i;
+}
+#endif
+
+void deinterleave(
+    const float* interleaved,
+    int numChannels,
+    int numFrames,
+    float* const* destinations,
+    float* const* mirrorDestinations)
+{
+    if (numChannels == 1) {
+        std::memcpy(destinations[0], interleaved, numFrames * sizeof(float));
+        std::memcpy(mirrorDestinations[0], interleaved, numFrames * sizeof(float));
+        return;
+    }
+    if (numChannels == 2) {
+        deinterleaveStereo(
+            interleaved, numFrames,
+            destinations[0], destinations[1],
+            mirrorDestinations[0], mirrorDestinations[1]);
+        return;
+    }
+    int start = 0;
+#if defined(__SSE2__)
+    start = deinterleaveBlocks(interleaved, numChannels, numFrames, destinations, mirrorDestinations);
+#endif
+    for (int channel = 0; channel < numChannels; channel++) {
+        float* destination = destinations[channel];
+        float* mirrorDestination = mirrorDestinations[channel];
+        const float* source = interleaved + channel;
+        for (int i = start; i < numFrames; i++) {
+            destination[i] = mirrorDestination[i] = source[i * numChannels];
+        }
+    }
+}
+
+void multiply(const float* a, const float* b, float* out, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void multiply(const float* a, const float* b, double* out, int n)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128 product = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        _mm_storeu_pd(out + i, _mm_cvtps_pd(product));
+        _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(product, product)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void magnitudeToDb(const float* complex, float* out, int n)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256 minimumPower = _mm256_set1_ps(k_minimumPower);
+    const __m256 dbPerOctave = _mm256_set1_ps(k_dbPerOctave);
+    for (; i + 8 <= n; i += 8) {
+        __m256 a = _mm256_loadu_ps(complex + 2 * i);
+        __m256 b = _mm256_loadu_ps(complex + 2 * i + 8);
+        a = _mm256_mul_ps(a, a);
+        b = _mm256_mul_ps(b, b);
+        // Per 128-bit lane, so the result comes out as bins 0 1 4 5 2 3 6 7.
+        __m256 power = _mm256_add_ps(
+            _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        power = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), _MM_SHUFFLE(3, 1, 2, 0)));
+        power = _mm256_max_ps(power, minimumPower);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(fastLog2(power), dbPerOctave));
+    }
+#elif defined(__SSE2__)
+    const __m128 minimumPower = _mm_set1_ps(k_minimumPower);
+    const __m128 dbPerOctave = _mm_set1_ps(k_dbPerOctave);
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(complex + 2 * i);
+        __m128 b = _mm_loadu_ps(complex + 2 * i + 4);
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 power = _mm_add_ps(
+            _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        power = _mm_max_ps(power, minimumPower);
+        _mm_storeu_ps(out + i, _mm_mul_ps(fastLog2(power), dbPerOctave));
+    }
+#endif
+    for (; i < n; i++) {
+        float real = complex[2 * i];
+        float imag = complex[2 * i + 1];
+        float power = std::max(real * real + imag * imag, k_minimumPower);
+        out[i] = fastLog2(power) * k_dbPerOctave;
+    }
+}
+
+void magnitudeToDb(const double* complex, float* out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        double real = complex[2 * i];
+        double imag = complex[2 * i + 1];
+        double power = std::max(real * real + imag * imag, static_cast<double>(k_minimumPower));
+        out[i] = 10 * std::log10(power);
+    }
+}
+
+float maximum(const float* in, int n)
+{
+    float result = in[0];
+    int i = 0;
+#if defined(__AVX__)
+    if (n >= 8) {
+        __m256 maxima = _mm256_loadu_ps(in);
+        for (i = 8; i + 8 <= n; i += 8) {
+            maxima = _mm256_max_ps(maxima, _mm256_loadu_ps(in + i));
+        }
+        __m128 half = _mm_max_ps(_mm256_castps256_ps128(maxima), _mm256_extractf128_ps(maxima, 1));
+        half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+        result = _mm_cvtss_f32(half);
+    }
+#elif defined(__SSE2__)
+    if (n >= 4) {
+        __m128 maxima = _mm_loadu_ps(in);
+        for (i = 4; i + 4 <= n; i += 4) {
+            maxima = _mm_max_ps(maxima, _mm_loadu_ps(in + i));
+        }
+        maxima = _mm_max_ps(maxima, _mm_movehl_ps(maxima, maxima));
+        maxima = _mm_max_ss(maxima, _mm_shuffle_ps(maxima, maxima, 1));
+        result = _mm_cvtss_f32(maxima);
+    }
+#endif
+    for (; i < n; i++) {
+        result = std::max(result, in[i]);
+    }
+    return result;
+}
+
+void smooth(const float* target, float* state, int n, float kAttack, float kRelease)
+{
+    // state + k (target - state) with k = 1 - kRelease or 1 - kAttack.
+    int i = 0;
+#if defined(__SSE2__)
+    __m128 attack = _mm_set1_ps(1 - kAttack);
+    __m128 release = _mm_set1_ps(1 - kRelease);
+    for (; i + 4 <= n; i += 4) {
+        __m128 current = _mm_loadu_ps(state + i);
+        __m128 goal = _mm_loadu_ps(target + i);
+        __m128 falling = _mm_cmpgt_ps(current, goal);
+        __m128 k = _mm_or_ps(_mm_and_ps(falling, release), _mm_andnot_ps(falling, attack));
+        _mm_storeu_ps(state + i, _mm_add_ps(current, _mm_mul_ps(k, _mm_sub_ps(goal, current))));
+    }
+#endif
+    for (; i < n; i++) {
+        float k = state[i] > target[i] ? 1 - kRelease : 1 - kAttack;
+        state[i] += k * (target[i] - state[i]);
+    }
+}
+
+void interpolate(const float* points, const float* weights, int resolution, int numChunks, float* out)
+{
+    int c = 0;
+#if defined(__SSE2__)
+    static const int k_maxGroups = 4;
+    int numGroups = (resolution + 3) / 4;
+    if (numGroups <= k_maxGroups) {
+        // columns[g][k] holds weight k of the four outputs 4g to 4g + 3,
+        // zero past resolution, so each group is four broadcasts times
+        // four columns.
+        __m128 columns[k_maxGroups][4];
+        for (int group = 0; group < numGroups; group++) {
+            for (int k = 0; k < 4; k++) {
+                float column[4] = { 0, 0, 0, 0 };
+                for (int lane = 0; lane < 4 && 4 * group + lane < resolution; lane++) {
+                    column[lane] = weights[(4 * group + lane) * 4 + k];
+                }
+                columns[group][k] = _mm_loadu_ps(column);
+            }
+        }
+        // A last group narrower than four spills into the following
+        // chunks' outputs, which those chunks then overwrite, so the chunks
+        // that would spill past the end are left to the scalar loop.
+        int spill = 4 * numGroups - resolution;
+        int end = numChunks - (spill + resolution - 1) / resolution;
+        for (; c < end; c++) {
+            __m128 p = _mm_loadu_ps(points + c);
+            __m128 p0 = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0));
+            __m128 p1 = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1));
+            __m128 p2 = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2));
+            __m128 p3 = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+            float* chunk = out + c * resolution;
+            for (int group = 0; group < numGroups; group++) {
+                __m128 sum = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(p0, columns[group][0]), _mm_mul_ps(p1, columns[group][1])),
+                    _mm_add_ps(_mm_mul_ps(p2, columns[group][2]), _mm_mul_ps(p3, columns[group][3])));
+                _mm_storeu_ps(chunk + 4 * group, sum);
+            }
+        }
+    }
+#endif
+    for (; c < numChunks; c++) {
+        const float* p = points + c;
+        for (int j = 0; j < resolution; j++) {
+            const float* w = weights + j * 4;
+            out[c * resolution + j] = w[0] * p[0] + w[1] * p[1] + w[2] * p[2] + w[3] * p[3];
+        }
+    }
+}
+
+void atan2(const float* y, const float* x, float* out, int n)
+{
+    const float* c = k_atanCoefficients;
+    int i = 0;
+#if defined(__SSE2__)
+    __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 absY = _mm_andnot_ps(signBit, vy);
+        __m128 absX = _mm_andnot_ps(signBit, vx);
+        __m128 larger = _mm_max_ps(absX, absY);
+        __m128 z = _mm_div_ps(_mm_min_ps(absX, absY), larger);
+        // 0 / 0 for the origin; atan2 gives 0 there.
+        z = _mm_and_ps(z, _mm_cmpgt_ps(larger, zero));
+        __m128 z2 = _mm_mul_ps(z, z);
+        __m128 r = _mm_set1_ps(c[5]);
+        for (int k = 4; k >= 0; k--) {
+            r = _mm_add_ps(_mm_mul_ps(r, z2), _mm_set1_ps(c[k]));
+        }
+        r = _mm_mul_ps(r, z);
+        __m128 steep = _mm_cmpgt_ps(absY, absX);
+        r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(k_pi / 2), r)), _mm_andnot_ps(steep, r));
+        __m128 left = _mm_cmplt_ps(vx, zero);
+        r = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(_mm_set1_ps(k_pi), r)), _mm_andnot_ps(left, r));
+        r = _mm_or_ps(r, _mm_and_ps(signBit, vy));
+        _mm_storeu_ps(out + i, r);
+    }
+#endif
+    for (; i < n; i++) {
+        float absY = std::fabs(y[i]);
+        float absX = std::fabs(x[i]);
+        float larger = std::max(absX, absY);
+        float z = larger > 0 ? std::min(absX, absY) / larger : 0;
+        float z2 = z * z;
+        float r = z * (c[0] + z2 * (c[1] + z2 * (c[2] + z2 * (c[3] + z2 * (c[4] + z2 * c[5])))));
+        if (absY > absX) {
+            r = k_pi / 2 - r;
+        }
+        if (x[i] < 0) {
+            r = k_pi - r;
+        }
+        out[i] = std::signbit(y[i]) ? -r : r;
+    }
+}
+
+void maximum(const float* a, const float* b, float* out, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_max_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = std::max(a[i], b[i]);
+    }
+}
+
+void minimum(const float* a, const float* b, float* out, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = std::min(a[i], b[i]);
+    }
+}
+
+void add(const float* in, float* accumulator, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(accumulator + i, _mm256_add_ps(_mm256_loadu_ps(accumulator + i), _mm256_loadu_ps(in + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(accumulator + i, _mm_add_ps(_mm_loadu_ps(accumulator + i), _mm_loadu_ps(in + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        accumulator[i] += in[i];
+    }
+}
+
+void dbToPower(const float* db, float* out, int n)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 octavesPerDb = _mm_set1_ps(k_octavesPerDb);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, fastExp2(_mm_mul_ps(_mm_loadu_ps(db + i), octavesPerDb)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = fastExp2(db[i] * k_octavesPerDb);
+    }
+}
+
+void powerToDb(const float* power, float scale, float* out, int n)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 minimumPower = _mm_set1_ps(k_minimumPower);
+    const __m128 dbPerOctave = _mm_set1_ps(k_dbPerOctave);
+    const __m128 scaleVector = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128 scaled = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(power + i), scaleVector), minimumPower);
+        _mm_storeu_ps(out + i, _mm_mul_ps(fastLog2(scaled), dbPerOctave));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = fastLog2(std::max(power[i] * scale, k_minimumPower)) * k_dbPerOctave;
+    }
+}
+
+void peakHold(const float* in, float* peak, float* age, int n, float elapsed, float holdTime, float fall)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 elapsedVector = _mm_set1_ps(elapsed);
+    const __m128 holdTimeVector = _mm_set1_ps(holdTime);
+    const __m128 fallVector = _mm_set1_ps(fall);
+    for (; i + 4 <= n; i += 4) {
+        __m128 level = _mm_loadu_ps(in + i);
+        __m128 held = _mm_loadu_ps(peak + i);
+        __m128 heldFor = _mm_add_ps(_mm_loadu_ps(age + i), elapsedVector);
+        __m128 rising = _mm_cmpge_ps(level, held);
+        __m128 falling = _mm_cmpgt_ps(heldFor, holdTimeVector);
+        __m128 fallen = _mm_max_ps(_mm_sub_ps(held, fallVector), level);
+        held = _mm_or_ps(_mm_and_ps(falling, fallen), _mm_andnot_ps(falling, held));
+        held = _mm_or_ps(_mm_and_ps(rising, level), _mm_andnot_ps(rising, held));
+        _mm_storeu_ps(peak + i, held);
+        _mm_storeu_ps(age + i, _mm_andnot_ps(rising, heldFor));
+    }
+#endif
+    for (; i < n; i++) {
+        float heldFor = age[i] + elapsed;
+        if (in[i] >= peak[i]) {
+            peak[i] = in[i];
+            age[i] = 0;
+            continue;
+        }
+        if (heldFor > holdTime) {
+            peak[i] = std::max(peak[i] - fall, in[i]);
+        }
+        age[i] = heldFor;
+    }
+}
+
+}
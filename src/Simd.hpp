@@ -0,0 +1,66 @@
+#pragma once
+
+// Array kernels for the analysis path. Each has an SSE/AVX implementation
+// where the target supports it and a scalar fallback otherwise. Pointers
+// need not be aligned.
+namespace simd {
+
+// Splits numFrames interleaved frames of numChannels samples into planar
+// buffers. Each channel's samples are written to both destinations, which is
+// what keeps mirrored history buffers contiguous.
+void deinterleave(
+    const float* interleaved,
+    int numChannels,
+    int numFrames,
+    float* const* destinations,
+    float* const* mirrorDestinations);
+
+// out[i] = a[i] * b[i]
+void multiply(const float* a, const float* b, float* out, int n);
+void multiply(const float* a, const float* b, double* out, int n);
+
+// Converts n interleaved complex values to power in dB, 10 * log10(re^2 +
+// im^2). The float version uses a polynomial log2 whose error is below
+// 1e-4 dB; the double version is exact and serves as the reference. Powers
+// below 1e-30 are clamped to it (-300 dB) so silence stays finite.
+void magnitudeToDb(const float* complex, float* out, int n);
+void magnitudeToDb(const double* complex, float* out, int n);
+
+// The largest of in[0..n), n >= 1.
+float maximum(const float* in, int n);
+
+// out[i] = max(a[i], b[i]) and out[i] = min(a[i], b[i]). out may alias a
+// or b.
+void maximum(const float* a, const float* b, float* out, int n);
+void minimum(const float* a, const float* b, float* out, int n);
+
+// accumulator[i] += in[i]
+void add(const float* in, float* accumulator, int n);
+
+// Conversions between dB and linear power, 10^(db / 10) and 10 *
+// log10(scale * power), through the same kind of polynomials as
+// magnitudeToDb(). Powers are clamped like there, and dB to within the range
+// of normal floats. out may alias the input.
+void dbToPower(const float* db, float* out, int n);
+void powerToDb(const float* power, float scale, float* out, int n);
+
+// Peak hold with a timed fall, in place. A level at or above peak[i] becomes
+// the new peak and restarts age[i], the seconds it has been held. Once held
+// for longer than holdTime, the peak falls by fall per call, but never
+// below the level. elapsed is the time in seconds since the last call.
+void peakHold(const float* in, float* peak, float* age, int n, float elapsed, float holdTime, float fall);
+
+// out[i] = atan2(y[i], x[i]), within 2e-6 radians. out may alias y or x.
+void atan2(const float* y, const float* x, float* out, int n);
+
+// Evaluates a curve with four-point weights at resolution points per
+// control point: out[c * resolution + j] = sum over k of weights[j * 4 + k] *
+// points[c + k], for c in [0, numChunks). points holds numChunks + 3 values.
+// The output is written in order, a chunk at a time.
+void interpolate(const float* points, const float* weights, int resolution, int numChunks, float* out);
+
+// Moves each state[i] toward target[i] by a one-pole filter: a fraction
+// 1 - kRelease of the way when falling, 1 - kAttack when rising.
+void smooth(const float* target, float* state, int n, float kAttack, float kRelease);
+
+}
@@ -0,0 +1,144 @@
+#include "SlidingDFT.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const double k_pi = 3.14159265358979;
+
+SlidingDFT::SlidingDFT(
+    int fftSize,
+    int numChannels,
+    float sampleRate,
+    int hopSize,
+    int binsPerOctave,
+    int referenceFFTSize)
+    : m_fftSize(fftSize)
+    , m_numChannels(numChannels)
+    , m_hopSize(hopSize)
+{
+    if (fftSize < 8 || hopSize < 1 || binsPerOctave < 1) {
+        throw std::runtime_error("Sliding DFT needs fftSize >= 8, a positive hop and positive bins per octave");
+    }
+
+    // Pick the bin nearest each log-spaced frequency; where bins are wider
+    // than the spacing this degenerates to every bin.
+    float binWidth = sampleRate / m_fftSize;
+    std::vector<int> outputBins;
+    float ratio = std::pow(2.0f, 1.0f / binsPerOctave);
+    for (float frequency = getLowestFrequency(); frequency < getHighestFrequency(); frequency *= ratio) {
+        int bin = std::min(std::max(static_cast<int>(std::round(frequency / binWidth)), 1), m_fftSize / 2 - 1);
+        if (outputBins.empty() || bin != outputBins.back()) {
+            outputBins.push_back(bin);
+        }
+    }
+
+    for (int bin : outputBins) {
+        for (int neighbour = bin - 1; neighbour <= bin + 1; neighbour++) {
+            if (m_rawBins.empty() || neighbour > m_rawBins.back()) {
+                m_rawBins.push_back(neighbour);
+            }
+        }
+        m_outputToRaw.push_back(
+            std::lower_bound(m_rawBins.begin(), m_rawBins.end(), bin) - m_rawBins.begin());
+        m_binFrequencies.push_back(bin * binWidth);
+    }
+
+    int numRawBins = m_rawBins.size();
+    for (int bin : m_rawBins) {
+        double angle = 2 * k_pi * bin / m_fftSize;
+        m_twiddleReal.push_back(std::cos(angle));
+        m_twiddleImag.push_back(std::sin(angle));
+    }
+    m_real.resize(m_numChannels * numRawBins);
+    m_imag.resize(m_numChannels * numRawBins);
+
+    m_windowed.resize(2 * outputBins.size());
+    m_magnitudes.resize(m_numChannels * outputBins.size(), -1000);
+
+    m_gainDb = 20 * std::log10(static_cast<float>(referenceFFTSize) / m_fftSize);
+}
+
+bool SlidingDFT::process(Ingress& ingress, int frameCount, uint64_t droppedFrames)
+{
+    if (frameCount == 0 && droppedFrames == 0) {
+        return false;
+    }
+    // The recurrence steps the accumulators through exactly one hop of
+    // contiguous samples. After a short read or a drop the window moved by
+    // something else, so the accumulators are rebuilt from it instead of
+    // staying wrong until the next scheduled resync.
+    m_samplesSinceResync += m_hopSize;
+    bool shouldResync = m_samplesSinceResync >= k_resyncInterval || frameCount != m_hopSize || droppedFrames > 0;
+    if (shouldResync) {
+        m_samplesSinceResync = 0;
+    }
+
+    int numRawBins = m_rawBins.size();
+    int numBins = getSpectrumSize();
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        const float* history = ingress.getHistory(channel, m_fftSize + m_hopSize);
+        if (shouldResync) {
+            resync(channel, history + m_hopSize);
+        } else {
+            slide(channel, history);
+        }
+
+        const double* real = &m_real[channel * numRawBins];
+        const double* imag = &m_imag[channel * numRawBins];
+        for (int i = 0; i < numBins; i++) {
+            int raw = m_outputToRaw[i];
+            m_windowed[2 * i] = 0.5 * real[raw] - 0.25 * (real[raw - 1] + real[raw + 1]);
+            m_windowed[2 * i + 1] = 0.5 * imag[raw] - 0.25 * (imag[raw - 1] + imag[raw + 1]);
+        }
+        float* magnitudes = &m_magnitudes[channel * numBins];
+        simd::magnitudeToDb(m_windowed.data(), magnitudes, numBins);
+        for (int i = 0; i < numBins; i++) {
+            magnitudes[i] += m_gainDb;
+        }
+    }
+    return true;
+}
+
+// history holds the hop's outgoing samples followed by the current window,
+// whose last hopSize samples are new. Each new sample x[n] updates every bin
+// as X[k] = (X[k] + x[n] - x[n - fftSize]) e^(2 pi i k / fftSize).
+void SlidingDFT::slide(int channel, const float* history)
+{
+    int numRawBins = m_rawBins.size();
+    double* real = &m_real[channel * numRawBins];
+    double* imag = &m_imag[channel * numRawBins];
+    const double* twiddleReal = m_twiddleReal.data();
+    const double* twiddleImag = m_twiddleImag.data();
+    for (int n = 0; n < m_hopSize; n++) {
+        double delta = static_cast<double>(history[n + m_fftSize]) - history[n];
+        for (int i = 0; i < numRawBins; i++) {
+            double shiftedReal = real[i] + delta;
+            double shiftedImag = imag[i];
+            real[i] = shiftedReal * twiddleReal[i] - shiftedImag * twiddleImag[i];
+            imag[i] = shiftedReal * twiddleImag[i] + shiftedImag * twiddleReal[i];
+        }
+    }
+}
+
+// Recomputes the accumulators as the plain DFT of the window, oldest sample
+// first, which is what the recurrence tracks.
+void SlidingDFT::resync(int channel, const float* window)
+{
+    int numRawBins = m_rawBins.size();
+    for (int i = 0; i < numRawBins; i++) {
+        double sumReal = 0;
+        double sumImag = 0;
+        double rotationReal = 1;
+        double rotationImag = 0;
+        for (int n = 0; n < m_fftSize; n++) {
+            sumReal += window[n] * rotationReal;
+            sumImag += window[n] * rotationImag;
+            double nextReal = rotationReal * m_twiddleReal[i] + rotationImag * m_twiddleImag[i];
+            rotationImag = rotationImag * m_twiddleReal[i] - rotationReal * m_twiddleImag[i];
+            rotationReal = nextReal;
+        }
+        m_real[channel * numRawBins + i] = sumReal;
+        m_imag[channel * numRawBins + i] = sumImag;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+
+#include "AnalysisEngine.hpp"
+#include "FFT.hpp"
+
+// Hann-windowed spectrum of the last fftSize samples, updated sample by
+// sample with a sliding DFT instead of retransformed every hop. Only a
+// log-spaced subset of bins (binsPerOctave per octave, at most every bin)
+// is tracked, which keeps the per-sample cost proportional to what can be
+// drawn. The window is applied in the frequency domain as
+// 0.5 X[k] - 0.25 (X[k - 1] + X[k + 1]), so levels match FFT exactly.
+class SlidingDFT : public AnalysisEngine {
+public:
+    // One audio block, so spectra arrive as fast as audio does.
+    static const int k_defaultHopSize = 256;
+
+    SlidingDFT(
+        int fftSize,
+        int numChannels,
+        float sampleRate,
+        int hopSize,
+        int binsPerOctave,
+        int referenceFFTSize);
+
+    int getHopSize() override { return m_hopSize; }
+    // Every hop subtracts the samples that left the window, so process()
+    // reads fftSize + hopSize frames.
+    int getLongestWindow() override { return m_fftSize + m_hopSize; }
+    int getNumChannels() override { return m_numChannels; }
+    const std::vector<float>& getBinFrequencies() override { return m_binFrequencies; }
+
+    // The sliding sums carry over from hop to hop between resyncs.
+    bool canStartMidStream() override { return false; }
+    bool process(Ingress& ingress, int frameCount, uint64_t droppedFrames) override;
+    const std::vector<float>& getMagnitudes() override { return m_magnitudes; }
+
+private:
+    // Rounding error in the recurrence grows without bound, however slowly,
+    // so the accumulators are recomputed from scratch this often (in
+    // samples, about 20 seconds at 48 kHz). They are also recomputed after
+    // any read that did not add exactly one hop.
+    static const int k_resyncInterval = 1 << 20;
+
+    const int m_fftSize;
+    const int m_numChannels;
+    const int m_hopSize;
+    float m_gainDb;
+
+    // Raw (unwindowed) DFT bins tracked by the recurrence, and their
+    // per-sample rotations e^(2 pi i k / fftSize).
+    std::vector<int> m_rawBins;
+    std::vector<double> m_twiddleReal;
+    std::vector<double> m_twiddleImag;
+    // [channel][raw bin] accumulators.
+    std::vector<double> m_real;
+    std::vector<double> m_imag;
+    int m_samplesSinceResync = 0;
+
+    // Each output bin's index into the raw bins. Its neighbours sit on
+    // either side of it.
+    std::vector<int> m_outputToRaw;
+    std::vector<float> m_windowed;
+    std::vector<float> m_binFrequencies;
+    std::vector<float> m_magnitudes;
+
+    void slide(int channel, const float* history);
+    void resync(int channel, const float* window);
+};
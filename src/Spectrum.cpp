@@ -1,6 +1,8 @@
 #include "Spectrum.hpp"
+#include "Simd.hpp"
 
-std::mutex g_magnitudeSpectrumMutex;
+#include <stdexcept>
+#include <utility>
 
 static float cubicInterpolate(float t, float y0, float y1, float y2, float y3)
 {
@@ -22,12 +24,12 @@ static float dCubicInterpolate(float t, float y0, float y1, float y2, float y3)
 }
 
 Spectrum::Spectrum(
-    int fftSize,
+    std::vector<float> binFrequencies,
     float plotPointPadding,
     float attack,
     float release)
-    : m_fftSize(fftSize)
-    , m_spectrumSize(fftSize / 2 + 1)
+    : m_binFrequencies(std::move(binFrequencies))
+    , m_spectrumSize(m_binFrequencies.size())
     , m_numChunks(0)
     , m_numPlotPoints(0)
     , m_plotPointPadding(plotPointPadding)
@@ -35,137 +37,180 @@ Spectrum::Spectrum(
     m_kAttack = 1 - std::exp(-attack);
     m_kRelease = 1 - std::exp(-release);
 
+    // Room for one chunk per bin, the most setWindowSize() can ask for.
+    m_chunkBinStart.reserve(m_spectrumSize + 1);
     m_chunkX.reserve(m_spectrumSize);
+    m_previousChunkX.reserve(m_spectrumSize);
     m_chunkY.reserve(m_spectrumSize);
     m_lastChunkY.reserve(m_spectrumSize);
+    m_paddedChunkX.reserve(m_spectrumSize + 3);
+    m_paddedChunkY.reserve(m_spectrumSize + 3);
 
     m_plotX.reserve(m_spectrumSize * m_cubicResolution);
     m_plotY.reserve(m_spectrumSize * m_cubicResolution);
+    m_plotDX.reserve(m_spectrumSize * m_cubicResolution);
     m_plotNormal.reserve(m_spectrumSize * m_cubicResolution);
 
-    m_binToChunk.reserve(m_spectrumSize);
+    // Plot point i lies at the same fraction t of the way between two chunks
+    // for every i with the same i % m_cubicResolution, so there are only
+    // m_cubicResolution distinct sets of Catmull-Rom weights.
+    m_basis.resize(m_cubicResolution * 4);
+    m_basisDerivative.resize(m_cubicResolution * 4);
+    for (int j = 0; j < m_cubicResolution; j++) {
+        float t = static_cast<float>(j) / m_cubicResolution;
+        for (int k = 0; k < 4; k++) {
+            float y[4] = { 0, 0, 0, 0 };
+            y[k] = 1;
+            m_basis[j * 4 + k] = cubicInterpolate(t, y[0], y[1], y[2], y[3]);
+            m_basisDerivative[j * 4 + k] = dCubicInterpolate(t, y[0], y[1], y[2], y[3]);
+        }
+    }
 }
 
-float Spectrum::fftBinToFrequency(int fftBin)
+void Spectrum::setFrequencyRange(float lowFrequency, float highFrequency)
 {
-    return 24000 * static_cast<float>(fftBin) / m_spectrumSize;
+    if (lowFrequency <= 0 || highFrequency <= lowFrequency) {
+        throw std::runtime_error("Frequency range must be positive and nonempty");
+    }
+    m_lowFrequency = lowFrequency;
+    m_highFrequency = highFrequency;
+}
+
+void Spectrum::setContentScale(float contentScale)
+{
+    if (contentScale <= 0) {
+        throw std::runtime_error("Content scale must be positive");
+    }
+    m_contentScale = contentScale;
 }
 
 float Spectrum::position(float frequency)
 {
-    return (std::log2(frequency) - std::log2(50)) / (std::log2(20e3) - std::log2(50));
+    return (std::log2(frequency) - std::log2(m_lowFrequency)) / (std::log2(m_highFrequency) - std::log2(m_lowFrequency));
 }
 
 void Spectrum::setWindowSize(int windowWidth, int windowHeight)
 {
+    m_windowWidth = windowWidth;
+    float chunkWidth = m_plotPointPadding * m_contentScale;
+    m_previousChunkX.swap(m_chunkX);
     m_chunkX.clear();
-
-    m_binToChunk.clear();
-    m_binToChunk.resize(m_spectrumSize);
-
-    bool foundMultiChunk = false;
-    int firstMultiChunk;
-    int firstMultiChunkOffset;
-    int chunkIndex;
-
-    int lastNominalChunk = -1;
-
-    for (int i = 0; i < m_spectrumSize; i++) {
-        float frequency = fftBinToFrequency(i);
-        float thePosition = position(frequency);
+    m_chunkBinStart.clear();
+
+    // Each bin starts a new chunk unless it falls in the same nominal chunk
+    // as the bin before it. Where bins are sparse this gives one chunk per
+    // bin; where they are dense, several bins share one chunk. Deciding per
+    // bin rather than switching modes once keeps this correct for spectra
+    // whose bin density changes, like stitched multi-resolution ones. Bins
+    // are in increasing frequency order, so every chunk is a contiguous run
+    // of bins, and bins past the right edge are all at the end.
+    int lastNominalChunk = 0;
+    int endBin = 0;
+    for (; endBin < m_spectrumSize; endBin++) {
+        float thePosition = position(fftBinToFrequency(endBin));
         if (thePosition > 1.0) {
-            m_binToChunk[i] = -1;
-            continue;
+            break;
         }
-        int nominalChunk = static_cast<int>(std::floor(thePosition * windowWidth / m_plotPointPadding));
-        if (foundMultiChunk) {
-            chunkIndex = firstMultiChunk + nominalChunk - firstMultiChunkOffset;
-            m_binToChunk[i] = chunkIndex;
-            if (nominalChunk != lastNominalChunk) {
-                m_chunkX.push_back(thePosition);
-            }
-        } else {
-            chunkIndex = i;
-            m_binToChunk[i] = i;
-            // FIXME may be an off-by-one error in here for the first multichunk
+        int nominalChunk = static_cast<int>(std::floor(thePosition * windowWidth / chunkWidth));
+        if (m_chunkX.empty() || nominalChunk != lastNominalChunk) {
             m_chunkX.push_back(thePosition);
-            if (nominalChunk == lastNominalChunk) {
-                foundMultiChunk = true;
-                firstMultiChunk = i;
-                firstMultiChunkOffset = nominalChunk;
-            }
+            m_chunkBinStart.push_back(endBin);
         }
         lastNominalChunk = nominalChunk;
     }
+    m_chunkBinStart.push_back(endBin);
 
     m_numChunks = m_chunkX.size();
-    m_chunkY.resize(m_numChunks);
+    resampleLevels();
+    // The control points with the first and last repeated on either side,
+    // so the curve needs no clamping at its ends.
+    m_paddedChunkX.resize(m_numChunks + 3);
+    m_paddedChunkY.resize(m_numChunks + 3);
 
     m_numPlotPoints = m_numChunks * m_cubicResolution;
-
-    m_plotY.resize(m_numPlotPoints);
     m_plotX.resize(m_numPlotPoints);
-
-    for (int i = 0; i < m_numPlotPoints; i++) {
-        int t1 = i / m_cubicResolution;
-        int t0 = std::max(t1 - 1, 0);
-        int t2 = std::min(t1 + 1, m_numChunks - 1);
-        int t3 = std::min(t1 + 2, m_numChunks - 1);
-        float x0 = m_chunkX[t0];
-        float x1 = m_chunkX[t1];
-        float x2 = m_chunkX[t2];
-        float x3 = m_chunkX[t3];
-        float t = static_cast<float>(i) / m_cubicResolution - t1;
-        m_plotX[i] = cubicInterpolate(t, x0, x1, x2, x3);
-    }
-
+    m_plotY.resize(m_numPlotPoints);
+    m_plotDX.resize(m_numPlotPoints);
     m_plotNormal.clear();
     m_plotNormal.resize(m_numPlotPoints);
+
+    if (m_numChunks == 0) {
+        return;
+    }
+    pad(m_chunkX.data(), m_paddedChunkX.data());
+    interpolate(m_paddedChunkX.data(), m_basis, m_plotX.data());
+    interpolate(m_paddedChunkX.data(), m_basisDerivative, m_plotDX.data());
 }
 
-void Spectrum::update(std::vector<float>& magnitudeSpectrum)
+// Carries the smoothed levels of the previous chunks over to the new ones,
+// interpolating between the previous chunks around each new one, so a
+// resize does not make the curves jump. m_chunkY is overwritten by every
+// updateChunks(), so it holds the result until the two are swapped.
+void Spectrum::resampleLevels()
 {
+    int numPrevious = m_previousChunkX.size();
+    m_chunkY.resize(m_numChunks);
+    int previous = 0;
     for (int i = 0; i < m_numChunks; i++) {
-        m_chunkY[i] = -1000;
-    }
-
-    {
-        const std::lock_guard<std::mutex> lock(g_magnitudeSpectrumMutex);
-        for (int i = 0; i < m_spectrumSize; i++) {
-            int chunk = m_binToChunk[i];
-            if (chunk < 0 || chunk >= static_cast<int>(m_chunkY.size())) {
-                break;
-            }
-            m_chunkY[chunk] = std::max(m_chunkY[chunk], magnitudeSpectrum[i]);
+        if (numPrevious == 0) {
+            m_chunkY[i] = -1000;
+            continue;
+        }
+        float x = m_chunkX[i];
+        while (previous < numPrevious - 1 && m_previousChunkX[previous + 1] <= x) {
+            previous++;
+        }
+        float level = m_lastChunkY[previous];
+        if (previous < numPrevious - 1 && x > m_previousChunkX[previous]) {
+            float t = (x - m_previousChunkX[previous]) / (m_previousChunkX[previous + 1] - m_previousChunkX[previous]);
+            level += t * (m_lastChunkY[previous + 1] - level);
         }
+        m_chunkY[i] = level;
     }
+    m_lastChunkY.swap(m_chunkY);
+    m_chunkY.resize(m_numChunks);
+}
 
-    for (int i = 0; i < m_numChunks; i++) {
-        if (m_lastChunkY[i] > m_chunkY[i]) {
-            m_lastChunkY[i] = m_lastChunkY[i] * m_kRelease + m_chunkY[i] * (1 - m_kRelease);
-        } else {
-            m_lastChunkY[i] = m_lastChunkY[i] * m_kAttack + m_chunkY[i] * (1 - m_kAttack);
-        }
+void Spectrum::pad(const float* chunks, float* padded)
+{
+    padded[0] = chunks[0];
+    std::copy(chunks, chunks + m_numChunks, padded + 1);
+    padded[m_numChunks + 1] = chunks[m_numChunks - 1];
+    padded[m_numChunks + 2] = chunks[m_numChunks - 1];
+}
+
+void Spectrum::interpolate(
+    const float* padded,
+    const std::vector<float>& weights,
+    float* out)
+{
+    simd::interpolate(padded, weights.data(), m_cubicResolution, m_numChunks, out);
+}
+
+void Spectrum::update(const float* magnitudeSpectrum)
+{
+    updateChunks(magnitudeSpectrum);
+    if (m_numChunks == 0) {
+        return;
     }
 
+    pad(m_lastChunkY.data(), m_paddedChunkY.data());
+    interpolate(m_paddedChunkY.data(), m_basis, m_plotY.data());
+    // The y-derivative lands in m_plotNormal and is turned into the angle
+    // in place.
+    interpolate(m_paddedChunkY.data(), m_basisDerivative, m_plotNormal.data());
     for (int i = 0; i < m_numPlotPoints; i++) {
-        int t1 = i / m_cubicResolution;
-        int t0 = std::max(t1 - 1, 0);
-        int t2 = std::min(t1 + 1, m_numChunks - 1);
-        int t3 = std::min(t1 + 2, m_numChunks - 1);
-        float y0 = m_lastChunkY[t0];
-        float y1 = m_lastChunkY[t1];
-        float y2 = m_lastChunkY[t2];
-        float y3 = m_lastChunkY[t3];
-        float t = static_cast<float>(i) / m_cubicResolution - t1;
-        m_plotY[i] = cubicInterpolate(t, y0, y1, y2, y3);
-        float x0 = m_chunkX[t0];
-        float x1 = m_chunkX[t1];
-        float x2 = m_chunkX[t2];
-        float x3 = m_chunkX[t3];
-        m_plotNormal[i] = std::atan2(
-            // FIXME: This 60 is hardcoded and should come from the RangeComputer.
-            dCubicInterpolate(t, y0, y1, y2, y3) / 60,
-            dCubicInterpolate(t, x0, x1, x2, x3));
+        // FIXME: This 60 is hardcoded and should come from the RangeComputer.
+        m_plotNormal[i] /= 60;
+    }
+    simd::atan2(m_plotNormal.data(), m_plotDX.data(), m_plotNormal.data(), m_numPlotPoints);
+}
+
+void Spectrum::updateChunks(const float* magnitudeSpectrum)
+{
+    for (int i = 0; i < m_numChunks; i++) {
+        int start = m_chunkBinStart[i];
+        m_chunkY[i] = simd::maximum(magnitudeSpectrum + start, m_chunkBinStart[i + 1] - start);
     }
+    simd::smooth(m_chunkY.data(), m_lastChunkY.data(), m_numChunks, m_kAttack, m_kRelease);
 }
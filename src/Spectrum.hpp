@@ -1,44 +1,86 @@
 #pragma once
+#include <array>
 #include <cmath>
-#include <mutex>
 #include <vector>
 
-extern std::mutex g_magnitudeSpectrumMutex;
-
 class Spectrum {
 public:
-    Spectrum(int fftSize, float plotPointPadding, float attack, float release);
-    int getFFTSize() { return m_fftSize; };
+    // binFrequencies gives the frequency of every bin of the magnitude
+    // spectra passed to update(), in increasing order. Bins need not be
+    // evenly spaced.
+    Spectrum(std::vector<float> binFrequencies, float plotPointPadding, float attack, float release);
+    int getSpectrumSize() { return m_spectrumSize; };
 
+    // Frequencies mapped to the left and right edges of the plot. Takes
+    // effect at the next setWindowSize().
+    void setFrequencyRange(float lowFrequency, float highFrequency);
+    // Framebuffer pixels per screen coordinate, 2 on a typical HiDPI
+    // display. Chunks are plotPointPadding times this wide, so curves look
+    // the same at any scale. Takes effect at the next setWindowSize().
+    void setContentScale(float contentScale);
+    // Chunks the spectrum for a plot windowWidth framebuffer pixels wide.
+    // Buffers only grow, up to their size for one chunk per bin, so calling
+    // this again never allocates. Smoothed levels carry over to the new
+    // chunks.
     void setWindowSize(int windowWidth, int windowHeight);
+    int getWindowWidth() { return m_windowWidth; }
     std::vector<float>& getPlotX() { return m_plotX; };
     std::vector<float>& getPlotY() { return m_plotY; };
     std::vector<float>& getPlotNormal() { return m_plotNormal; };
     int getNumPlotPoints() { return m_numPlotPoints; }
 
-    void update(std::vector<float>& magnitudeSpectrum);
+    // Reduces a magnitude spectrum to chunks and smooths them, then
+    // interpolates the plot points. updateChunks() does only the first half,
+    // for renderers that interpolate on the GPU.
+    void update(const float* magnitudeSpectrum);
+    void updateChunks(const float* magnitudeSpectrum);
+
+    // Chunk positions in [0, 1] and smoothed chunk levels in dB, the control
+    // points of the Catmull-Rom curve through the plot points.
+    const std::vector<float>& getChunkX() { return m_chunkX; }
+    const std::vector<float>& getChunkY() { return m_lastChunkY; }
+    int getCubicResolution() { return m_cubicResolution; }
 
-    float fftBinToFrequency(int fftBin);
+    float fftBinToFrequency(int fftBin) { return m_binFrequencies[fftBin]; };
     float position(float frequency);
 
 private:
-    const int m_fftSize;
+    const std::vector<float> m_binFrequencies;
     const int m_spectrumSize;
+    float m_lowFrequency = 50;
+    float m_highFrequency = 20e3;
+    float m_contentScale = 1;
+    int m_windowWidth = 0;
 
-    std::vector<int> m_binToChunk;
+    // Chunk i covers bins [m_chunkBinStart[i], m_chunkBinStart[i + 1]).
+    std::vector<int> m_chunkBinStart;
     int m_numChunks;
     std::vector<float> m_chunkX;
+    // Chunk positions before the last setWindowSize().
+    std::vector<float> m_previousChunkX;
     std::vector<float> m_chunkY;
     std::vector<float> m_lastChunkY;
+    std::vector<float> m_paddedChunkX;
+    std::vector<float> m_paddedChunkY;
 
     const int m_cubicResolution = 5;
     std::vector<float> m_plotX;
     std::vector<float> m_plotY;
     std::vector<float> m_plotNormal;
+    // Derivative of m_plotX, which only changes with the window size.
+    std::vector<float> m_plotDX;
     int m_numPlotPoints;
+    // [point][4] Catmull-Rom weights, and the weights of its derivative,
+    // for each of the m_cubicResolution plot points between two chunks.
+    std::vector<float> m_basis;
+    std::vector<float> m_basisDerivative;
 
     float m_kAttack;
     float m_kRelease;
 
     float m_plotPointPadding;
+
+    void pad(const float* chunks, float* padded);
+    void resampleLevels();
+    void interpolate(const float* padded, const std::vector<float>& weights, float* out);
 };
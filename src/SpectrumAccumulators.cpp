@@ -0,0 +1,132 @@
+#include "SpectrumAccumulators.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SpectrumAccumulators::SpectrumAccumulators(int spectrumSize, const AccumulatorSettings& settings)
+    : m_spectrumSize(spectrumSize)
+    , m_settings(settings)
+    , m_power(spectrumSize)
+{
+    if (settings.peakHoldTime < 0 || settings.peakFallRate < 0
+        || settings.averageTime < 0 || settings.windowTime < 0) {
+        throw std::runtime_error("Accumulator times and rates cannot be negative");
+    }
+
+    if (settings.peakHold) {
+        m_kinds.push_back(AccumulatorKind::PeakHold);
+        m_peakAge.resize(spectrumSize);
+    }
+    if (settings.minimumHold) {
+        m_kinds.push_back(AccumulatorKind::MinimumHold);
+    }
+    if (settings.averageTime > 0) {
+        m_kinds.push_back(AccumulatorKind::ExponentialAverage);
+        m_averagePower.resize(spectrumSize);
+    }
+    if (settings.windowTime > 0) {
+        m_kinds.push_back(AccumulatorKind::WindowAverage);
+        m_slotPower.resize(k_windowSlots * spectrumSize);
+        m_slotSpectra.resize(k_windowSlots);
+        m_windowPower.resize(spectrumSize);
+    }
+    m_traces.resize(m_kinds.size() * spectrumSize, -1000);
+}
+
+float* SpectrumAccumulators::getTrace(AccumulatorKind kind)
+{
+    int trace = std::find(m_kinds.begin(), m_kinds.end(), kind) - m_kinds.begin();
+    return &m_traces[trace * m_spectrumSize];
+}
+
+void SpectrumAccumulators::restart(const float* spectrum)
+{
+    for (size_t trace = 0; trace < m_kinds.size(); trace++) {
+        std::copy(spectrum, spectrum + m_spectrumSize, m_traces.begin() + trace * m_spectrumSize);
+    }
+    std::fill(m_peakAge.begin(), m_peakAge.end(), 0);
+    if (!m_averagePower.empty()) {
+        std::copy(m_power.begin(), m_power.end(), m_averagePower.begin());
+    }
+    if (!m_slotPower.empty()) {
+        std::fill(m_slotPower.begin(), m_slotPower.end(), 0);
+        std::fill(m_slotSpectra.begin(), m_slotSpectra.end(), 0);
+        m_slot = 0;
+        m_slotElapsed = 0;
+        std::copy(m_power.begin(), m_power.end(), m_slotPower.begin());
+        std::copy(m_power.begin(), m_power.end(), m_windowPower.begin());
+        m_slotSpectra[0] = 1;
+    }
+}
+
+void SpectrumAccumulators::process(const float* spectrum, float elapsed)
+{
+    if (m_kinds.empty()) {
+        return;
+    }
+    if (!m_averagePower.empty() || !m_windowPower.empty()) {
+        simd::dbToPower(spectrum, m_power.data(), m_spectrumSize);
+    }
+    m_numSpectra++;
+    if (m_numSpectra == 1) {
+        restart(spectrum);
+        return;
+    }
+
+    if (m_settings.peakHold) {
+        simd::peakHold(
+            spectrum,
+            getTrace(AccumulatorKind::PeakHold),
+            m_peakAge.data(),
+            m_spectrumSize,
+            elapsed,
+            m_settings.peakHoldTime,
+            m_settings.peakFallRate * elapsed);
+    }
+    if (m_settings.minimumHold) {
+        float* minimum = getTrace(AccumulatorKind::MinimumHold);
+        simd::minimum(minimum, spectrum, minimum, m_spectrumSize);
+    }
+    if (!m_averagePower.empty()) {
+        // Until a time constant has passed, this is the plain mean of
+        // everything so far, so the first spectrum does not linger.
+        float k = std::max(
+            1 - std::exp(-elapsed / m_settings.averageTime),
+            1.0f / m_numSpectra);
+        simd::smooth(m_power.data(), m_averagePower.data(), m_spectrumSize, 1 - k, 1 - k);
+        simd::powerToDb(
+            m_averagePower.data(), 1, getTrace(AccumulatorKind::ExponentialAverage), m_spectrumSize);
+    }
+    if (!m_windowPower.empty()) {
+        updateWindow(elapsed);
+    }
+}
+
+void SpectrumAccumulators::updateWindow(float elapsed)
+{
+    float slotTime = m_settings.windowTime / k_windowSlots;
+    m_slotElapsed += elapsed;
+    if (m_slotElapsed >= slotTime) {
+        m_slotElapsed = std::fmod(m_slotElapsed, slotTime);
+        m_slot = (m_slot + 1) % k_windowSlots;
+        std::fill_n(m_slotPower.begin() + m_slot * m_spectrumSize, m_spectrumSize, 0);
+        m_slotSpectra[m_slot] = 0;
+        std::fill(m_windowPower.begin(), m_windowPower.end(), 0);
+        for (int slot = 0; slot < k_windowSlots; slot++) {
+            simd::add(&m_slotPower[slot * m_spectrumSize], m_windowPower.data(), m_spectrumSize);
+        }
+    }
+
+    simd::add(m_power.data(), &m_slotPower[m_slot * m_spectrumSize], m_spectrumSize);
+    simd::add(m_power.data(), m_windowPower.data(), m_spectrumSize);
+    m_slotSpectra[m_slot]++;
+
+    int numSpectra = 0;
+    for (int count : m_slotSpectra) {
+        numSpectra += count;
+    }
+    simd::powerToDb(
+        m_windowPower.data(), 1.0f / numSpectra, getTrace(AccumulatorKind::WindowAverage), m_spectrumSize);
+}
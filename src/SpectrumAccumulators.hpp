@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+
+enum class AccumulatorKind {
+    PeakHold,
+    MinimumHold,
+    ExponentialAverage,
+    WindowAverage,
+};
+
+// Which traces to keep. Every trace is off by default.
+struct AccumulatorSettings {
+    bool peakHold = false;
+    // Seconds a peak is held before it starts to fall, and how fast it
+    // falls then, in dB per second.
+    float peakHoldTime = 2;
+    float peakFallRate = 20;
+    bool minimumHold = false;
+    // Time constant in seconds of the exponential average, or 0 for none.
+    float averageTime = 0;
+    // Length in seconds of the sliding-window average, or 0 for none.
+    float windowTime = 0;
+};
+
+// Long-term traces of a spectrum in dB, updated in place as every new
+// spectrum arrives: a peak hold whose peaks fall after a while, a minimum
+// hold, and averages of linear power (not of dB, which would read low on
+// anything noisy), one exponential and one over a sliding window.
+//
+// The sliding window is divided into k_windowSlots slots, each holding the
+// sum of the powers that arrived during its share of the window. When a slot
+// is full the oldest one is emptied and reused, so the window always covers
+// between k_windowSlots - 1 and k_windowSlots slots' worth of time, however
+// irregularly spectra arrive. Its running sum is rebuilt from the slots at
+// every turn, so rounding errors never pile up.
+class SpectrumAccumulators {
+public:
+    SpectrumAccumulators(int spectrumSize, const AccumulatorSettings& settings);
+
+    int getNumTraces() { return m_kinds.size(); }
+    const std::vector<AccumulatorKind>& getKinds() { return m_kinds; }
+
+    // Adds a spectrum in dB that arrived elapsed seconds after the last.
+    void process(const float* spectrum, float elapsed);
+    // Forgets everything; the next spectrum starts every trace over.
+    void reset() { m_numSpectra = 0; }
+
+    // [trace][bin] levels in dB, traces in the order of getKinds().
+    const std::vector<float>& getTraces() { return m_traces; }
+
+private:
+    static const int k_windowSlots = 16;
+
+    const int m_spectrumSize;
+    const AccumulatorSettings m_settings;
+    std::vector<AccumulatorKind> m_kinds;
+    std::vector<float> m_traces;
+    // Spectra since the last reset.
+    int m_numSpectra = 0;
+
+    std::vector<float> m_power;
+    // Seconds each bin's peak has been held.
+    std::vector<float> m_peakAge;
+    std::vector<float> m_averagePower;
+
+    // [slot][bin] sums of power, and how many spectra went into each slot.
+    std::vector<float> m_slotPower;
+    std::vector<int> m_slotSpectra;
+    int m_slot = 0;
+    float m_slotElapsed = 0;
+    // Sum over all slots.
+    std::vector<float> m_windowPower;
+
+    float* getTrace(AccumulatorKind kind);
+    void restart(const float* spectrum);
+    void updateWindow(float elapsed);
+};
@@ -0,0 +1,148 @@
+#include "SpectrumView.hpp"
+
+#include <stdexcept>
+
+static int traceColor(AccumulatorKind kind)
+{
+    switch (kind) {
+    case AccumulatorKind::PeakHold:
+        return 0xcc6666;
+    case AccumulatorKind::MinimumHold:
+        return 0x81a2be;
+    case AccumulatorKind::ExponentialAverage:
+        return 0xc5c8c6;
+    case AccumulatorKind::WindowAverage:
+        return 0xb294bb;
+    }
+    return 0xc5c8c6;
+}
+
+SpectrumView::SpectrumView(
+    const std::vector<float>& binFrequencies,
+    int numChannels,
+    float lowestFrequency,
+    float highestFrequency,
+    bool gpuCurves,
+    int waterfallRows,
+    float persistence,
+    float frameInterval,
+    const std::vector<AccumulatorKind>& traces)
+    : m_numChannels(numChannels)
+    , m_renderer(gpuCurves)
+{
+    m_maximumSpectrum.reset(new Spectrum(binFrequencies, 2, 3, 5));
+    m_maximumSpectrum->setFrequencyRange(lowestFrequency, highestFrequency);
+    m_renderer.addLayer(*m_maximumSpectrum, colorFromHex(0x3c3d3b), 8.0, true);
+
+    for (int channel = 0; channel < numChannels; channel++) {
+        m_channelSpectra.emplace_back(new Spectrum(binFrequencies, 2, 0.1, 1.5));
+        Spectrum& spectrum = *m_channelSpectra.back();
+        spectrum.setFrequencyRange(lowestFrequency, highestFrequency);
+        m_renderer.addLayer(
+            spectrum,
+            channelColor(channel, 0.8),
+            8.0,
+            false);
+    }
+
+    // The accumulators already did all the smoothing the traces need.
+    for (AccumulatorKind kind : traces) {
+        m_traceSpectra.emplace_back(new Spectrum(binFrequencies, 2, 0, 0));
+        Spectrum& spectrum = *m_traceSpectra.back();
+        spectrum.setFrequencyRange(lowestFrequency, highestFrequency);
+        m_renderer.addLayer(spectrum, colorFromHex(traceColor(kind), 0.9), 3.0, false);
+    }
+
+    if (waterfallRows > 0) {
+        if (!WaterfallRenderer::isSupported()) {
+            throw std::runtime_error("The waterfall needs OpenGL 3.1.");
+        }
+        // Lightly smoothed, like the channel curves, so the rows stay sharp
+        // in time.
+        m_waterfallSpectrum.reset(new Spectrum(binFrequencies, 2, 0.1, 1.5));
+        m_waterfallSpectrum->setFrequencyRange(lowestFrequency, highestFrequency);
+        m_waterfall.reset(new WaterfallRenderer(*m_waterfallSpectrum, waterfallRows));
+    }
+
+    if (persistence > 0) {
+        if (!PersistenceBuffer::isSupported()) {
+            throw std::runtime_error("Persistence needs OpenGL 3.1.");
+        }
+        m_persistence.reset(new PersistenceBuffer(persistence, frameInterval, colorFromHex(k_backgroundColor)));
+    }
+}
+
+void SpectrumView::setFrameInterval(float frameInterval)
+{
+    if (m_persistence) {
+        m_persistence->setFrameInterval(frameInterval);
+    }
+}
+
+void SpectrumView::setContentScale(float contentScale)
+{
+    m_maximumSpectrum->setContentScale(contentScale);
+    for (auto& spectrum : m_channelSpectra) {
+        spectrum->setContentScale(contentScale);
+    }
+    for (auto& spectrum : m_traceSpectra) {
+        spectrum->setContentScale(contentScale);
+    }
+    if (m_waterfallSpectrum) {
+        m_waterfallSpectrum->setContentScale(contentScale);
+    }
+}
+
+void SpectrumView::setWindowSize(int width, int height)
+{
+    int curveHeight = height - getWaterfallHeight(height);
+    m_maximumSpectrum->setWindowSize(width, curveHeight);
+    for (auto& spectrum : m_channelSpectra) {
+        spectrum->setWindowSize(width, curveHeight);
+    }
+    for (auto& spectrum : m_traceSpectra) {
+        spectrum->setWindowSize(width, curveHeight);
+    }
+    if (m_waterfallSpectrum) {
+        m_waterfallSpectrum->setWindowSize(width, getWaterfallHeight(height));
+    }
+}
+
+void SpectrumView::render(const AnalysisFrame& frame, int y, int width, int height)
+{
+    m_rangeComputer.process(frame.maximum);
+
+    if (m_renderer.usesGPUCurves()) {
+        m_maximumSpectrum->updateChunks(frame.maximumSpectrum.data());
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            m_channelSpectra[channel]->updateChunks(frame.getMagnitudeSpectrum(channel));
+        }
+        for (size_t trace = 0; trace < m_traceSpectra.size(); trace++) {
+            m_traceSpectra[trace]->updateChunks(frame.getTrace(trace));
+        }
+    } else {
+        m_maximumSpectrum->update(frame.maximumSpectrum.data());
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            m_channelSpectra[channel]->update(frame.getMagnitudeSpectrum(channel));
+        }
+        for (size_t trace = 0; trace < m_traceSpectra.size(); trace++) {
+            m_traceSpectra[trace]->update(frame.getTrace(trace));
+        }
+    }
+
+    int waterfallHeight = getWaterfallHeight(height);
+    if (m_waterfall) {
+        m_waterfallSpectrum->updateChunks(frame.maximumSpectrum.data());
+        glViewport(0, y, width, waterfallHeight);
+        m_waterfall->render(m_rangeComputer);
+    }
+    int curveHeight = height - waterfallHeight;
+    if (m_persistence) {
+        m_persistence->begin(width, curveHeight);
+        m_renderer.render(m_rangeComputer, width, curveHeight);
+        m_persistence->end(0, y + waterfallHeight);
+    } else {
+        glViewport(0, y + waterfallHeight, width, curveHeight);
+        m_renderer.render(m_rangeComputer, width, curveHeight);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Analyzer.hpp"
+#include "Colors.hpp"
+#include "FFT.hpp"
+#include "PersistenceBuffer.hpp"
+#include "ScopeRenderer.hpp"
+#include "Spectrum.hpp"
+#include "WaterfallRenderer.hpp"
+
+// The spectrum display: a filled curve of the maximum over all channels,
+// with a stroked curve per channel on top, a thin curve per accumulator
+// trace above those, and optionally a waterfall of the maximum below them.
+// Shared by the window and the headless renderer so both draw exactly the
+// same thing.
+class SpectrumView {
+public:
+    // The curves leave a trail if persistence is nonzero, fading by 1/e
+    // every persistence seconds when frames come frameInterval seconds
+    // apart.
+    SpectrumView(
+        const std::vector<float>& binFrequencies,
+        int numChannels,
+        float lowestFrequency,
+        float highestFrequency,
+        bool gpuCurves,
+        int waterfallRows,
+        float persistence,
+        float frameInterval,
+        const std::vector<AccumulatorKind>& traces);
+
+    SpectrumView(const SpectrumView& other) = delete;
+    SpectrumView& operator=(const SpectrumView& other) = delete;
+
+    bool usesGPUCurves() { return m_renderer.usesGPUCurves(); }
+
+    // Size of the area the view is drawn into, which the curves are chunked
+    // for. Call before the first render(). Rendering into a different size
+    // in between stretches the last layout over it.
+    void setWindowSize(int width, int height);
+    // Takes effect at the next setWindowSize().
+    void setContentScale(float contentScale);
+    // The time since the last frame, for a window whose frames do not come
+    // at a fixed rate. Takes effect at the next render().
+    void setFrameInterval(float frameInterval);
+    // Draws into window rows [y, y + height), leaving the viewport changed.
+    void render(const AnalysisFrame& frame, int y, int width, int height);
+
+private:
+    const int m_numChannels;
+    ScopeRenderer m_renderer;
+    RangeComputer m_rangeComputer;
+    std::unique_ptr<Spectrum> m_maximumSpectrum;
+    std::vector<std::unique_ptr<Spectrum>> m_channelSpectra;
+    std::vector<std::unique_ptr<Spectrum>> m_traceSpectra;
+    std::unique_ptr<Spectrum> m_waterfallSpectrum;
+    std::unique_ptr<WaterfallRenderer> m_waterfall;
+    std::unique_ptr<PersistenceBuffer> m_persistence;
+
+    int getWaterfallHeight(int height) { return m_waterfall ? height / 2 : 0; }
+};
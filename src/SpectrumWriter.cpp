@@ -0,0 +1,141 @@
+#include "SpectrumWriter.hpp"
+#include "Clock.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+static const char* traceName(AccumulatorKind kind)
+{
+    switch (kind) {
+    case AccumulatorKind::PeakHold:
+        return "peak_hold";
+    case AccumulatorKind::MinimumHold:
+        return "minimum_hold";
+    case AccumulatorKind::ExponentialAverage:
+        return "average";
+    case AccumulatorKind::WindowAverage:
+        return "window_average";
+    }
+    return "unknown";
+}
+
+SpectrumWriter::SpectrumWriter(
+    const std::string& path,
+    const std::vector<float>& binFrequencies,
+    int numChannels,
+    float sampleRate,
+    const std::vector<AccumulatorKind>& traces)
+    : m_path(path)
+    , m_binFrequencies(binFrequencies)
+    , m_numChannels(numChannels)
+    , m_sampleRate(sampleRate)
+    , m_traces(traces)
+{
+    open();
+}
+
+SpectrumWriter::~SpectrumWriter()
+{
+    if (m_file && m_file != stdout) {
+        std::fclose(m_file);
+    }
+}
+
+void SpectrumWriter::open()
+{
+    if (m_path == "-") {
+        m_file = stdout;
+    } else {
+        m_file = std::fopen(m_path.c_str(), "a");
+        if (!m_file) {
+            throw std::runtime_error("Could not open " + m_path);
+        }
+    }
+    m_headerPending = true;
+}
+
+void SpectrumWriter::reopen()
+{
+    if (m_file == stdout) {
+        return;
+    }
+    // Open the new file before closing the old one, so a failure leaves
+    // the writer where it was.
+    FILE* file = std::fopen(m_path.c_str(), "a");
+    if (!file) {
+        throw std::runtime_error("Could not reopen " + m_path + ", still writing to the old file");
+    }
+    std::fclose(m_file);
+    m_file = file;
+    m_headerPending = true;
+}
+
+void SpectrumWriter::writeHeader()
+{
+    std::fprintf(
+        m_file,
+        "{\"type\":\"header\",\"sample_rate\":%g,\"channels\":%d,\"traces\":[",
+        m_sampleRate,
+        m_numChannels);
+    for (size_t trace = 0; trace < m_traces.size(); trace++) {
+        std::fprintf(m_file, "%s\"%s\"", trace > 0 ? "," : "", traceName(m_traces[trace]));
+    }
+    std::fputs("],\"bin_frequencies\":[", m_file);
+    for (size_t bin = 0; bin < m_binFrequencies.size(); bin++) {
+        std::fprintf(m_file, "%s%.2f", bin > 0 ? "," : "", m_binFrequencies[bin]);
+    }
+    std::fputs("]}", m_file);
+    finishLine();
+    m_headerPending = false;
+}
+
+void SpectrumWriter::write(const AnalysisFrame& frame)
+{
+    if (m_headerPending) {
+        writeHeader();
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    // How long ago the newest sample in the frame was captured.
+    double age = getSteadyTime() - frame.newestSampleTime;
+    std::fprintf(
+        m_file,
+        "{\"type\":\"spectrum\",\"time\":%.3f,\"age\":%.4f,\"maximum\":%.1f,\"dropped_frames\":%llu,\"channels\":[",
+        wallTime,
+        age,
+        frame.maximum,
+        static_cast<unsigned long long>(frame.ingressStats.droppedFrames));
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        std::fputs(channel > 0 ? ",[" : "[", m_file);
+        writeLevels(frame.getMagnitudeSpectrum(channel), frame.spectrumSize);
+        std::fputc(']', m_file);
+    }
+    std::fputs("],\"traces\":{", m_file);
+    for (size_t trace = 0; trace < m_traces.size(); trace++) {
+        std::fprintf(m_file, "%s\"%s\":[", trace > 0 ? "," : "", traceName(m_traces[trace]));
+        writeLevels(frame.getTrace(trace), frame.spectrumSize);
+        std::fputc(']', m_file);
+    }
+    std::fputs("}}", m_file);
+    finishLine();
+}
+
+void SpectrumWriter::writeLevels(const float* levels, int count)
+{
+    for (int i = 0; i < count; i++) {
+        std::fprintf(m_file, i > 0 ? ",%.1f" : "%.1f", levels[i]);
+    }
+}
+
+void SpectrumWriter::finishLine()
+{
+    std::fputc('\n', m_file);
+    if (std::fflush(m_file) != 0 || std::ferror(m_file)) {
+        m_readerGone = errno == EPIPE;
+        // The error flag is sticky, so without this the next line would
+        // fail too even once there is room again.
+        std::clearerr(m_file);
+        throw std::runtime_error("Could not write to " + m_path + ": " + std::strerror(errno));
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Analyzer.hpp"
+
+// Writes analysis frames as JSON Lines, one object per line, for the
+// windowless daemon. Every file starts with a header object giving the bin
+// frequencies and what the traces are; every frame after it is an object
+// with the levels of every channel and trace in dB, rounded to 0.1 dB.
+// Each line is flushed as it is written, so a reader following the file or
+// a pipe never sees half of one.
+class SpectrumWriter {
+public:
+    // path "-" is stdout. Anything else is appended to.
+    SpectrumWriter(
+        const std::string& path,
+        const std::vector<float>& binFrequencies,
+        int numChannels,
+        float sampleRate,
+        const std::vector<AccumulatorKind>& traces);
+    ~SpectrumWriter();
+
+    SpectrumWriter(const SpectrumWriter& other) = delete;
+    SpectrumWriter& operator=(const SpectrumWriter& other) = delete;
+
+    // Writes the file's header first if it has not been written yet. Throws
+    // if a line could not be written; the next write tries again.
+    void write(const AnalysisFrame& frame);
+    // Whether the last failed write found the reading end of a pipe closed,
+    // so no later write can succeed.
+    bool isReaderGone() const { return m_readerGone; }
+    // Closes and reopens the file by name, so a log rotator can move it
+    // away. The new file starts with a header. If the file cannot be
+    // opened, throws and carries on writing to the old one.
+    void reopen();
+
+private:
+    const std::string m_path;
+    const std::vector<float> m_binFrequencies;
+    const int m_numChannels;
+    const float m_sampleRate;
+    const std::vector<AccumulatorKind> m_traces;
+    FILE* m_file = nullptr;
+    // The header goes out with the first frame, so that failing to write
+    // it is handled like failing to write a frame.
+    bool m_headerPending = true;
+    bool m_readerGone = false;
+
+    void open();
+    void writeHeader();
+    void writeLevels(const float* levels, int count);
+    void finishLine();
+};
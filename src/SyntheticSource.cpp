@@ -0,0 +1,46 @@
+#include "SyntheticSource.hpp"
+
+#include <cmath>
+
+static const double k_pi = 3.14159265358979;
+static const double k_sweepPeriod = 20;
+static const double k_sweepLow = 50;
+static const double k_sweepHigh = 10e3;
+
+SyntheticSource::SyntheticSource(int numChannels, float sampleRate)
+    : m_numChannels(numChannels)
+    , m_sampleRate(sampleRate)
+    , m_tonePhases(numChannels, 0)
+{
+    for (int channel = 0; channel < numChannels; channel++) {
+        // Spread the tones a fifth apart from 220 Hz.
+        m_toneSteps.push_back(2 * k_pi * 220 * std::pow(1.5, channel) / sampleRate);
+    }
+}
+
+// xorshift32, scaled to [-0.001, 0.001).
+float SyntheticSource::noise()
+{
+    m_noiseState ^= m_noiseState << 13;
+    m_noiseState ^= m_noiseState >> 17;
+    m_noiseState ^= m_noiseState << 5;
+    return (static_cast<float>(m_noiseState) / 4294967296.0f * 2 - 1) * 0.001f;
+}
+
+void SyntheticSource::generate(float* interleaved, int numFrames)
+{
+    for (int i = 0; i < numFrames; i++, m_frame++) {
+        // Triangle wave from 0 to 1 and back over one sweep period.
+        double position = std::fmod(m_frame / (m_sampleRate * k_sweepPeriod), 1.0);
+        double sweep = 1 - std::fabs(2 * position - 1);
+        double frequency = k_sweepLow * std::pow(k_sweepHigh / k_sweepLow, sweep);
+        m_sweepPhase = std::fmod(m_sweepPhase + 2 * k_pi * frequency / m_sampleRate, 2 * k_pi);
+        float sweepSample = 0.25f * std::sin(m_sweepPhase);
+
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            double& phase = m_tonePhases[channel];
+            phase = std::fmod(phase + m_toneSteps[channel], 2 * k_pi);
+            interleaved[i * m_numChannels + channel] = sweepSample + 0.1f * std::sin(phase) + noise();
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// A test signal for running without an audio device. Every channel gets a
+// sine sweeping logarithmically from 50 Hz to 10 kHz and back every 20
+// seconds, a steady tone of its own, and white noise at -60 dB, so spectra
+// have moving peaks, fixed peaks and a noise floor.
+class SyntheticSource {
+public:
+    SyntheticSource(int numChannels, float sampleRate);
+
+    void generate(float* interleaved, int numFrames);
+
+private:
+    const int m_numChannels;
+    const float m_sampleRate;
+    uint64_t m_frame = 0;
+    uint32_t m_noiseState = 1;
+    double m_sweepPhase = 0;
+    std::vector<double> m_tonePhases;
+    std::vector<double> m_toneSteps;
+
+    float noise();
+};
@@ -0,0 +1,152 @@
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+RollingStats::RollingStats()
+    : m_values(k_capacity)
+{
+    m_sorted.reserve(k_capacity);
+}
+
+void RollingStats::add(double value)
+{
+    m_values[m_next] = value;
+    m_next = (m_next + 1) % k_capacity;
+    if (m_count < k_capacity) {
+        m_count++;
+    }
+}
+
+RollingStats::Summary RollingStats::summarize()
+{
+    Summary summary;
+    summary.count = m_count;
+    if (m_count == 0) {
+        return summary;
+    }
+    m_sorted.assign(m_values.begin(), m_values.begin() + m_count);
+    std::sort(m_sorted.begin(), m_sorted.end());
+    auto percentile = [&](double p) {
+        return m_sorted[std::min(m_sorted.size() - 1, static_cast<size_t>(p / 100 * m_sorted.size()))];
+    };
+    double sum = 0;
+    for (double value : m_sorted) {
+        sum += value;
+    }
+    summary.mean = sum / m_count;
+    summary.p50 = percentile(50);
+    summary.p90 = percentile(90);
+    summary.p99 = percentile(99);
+    summary.max = m_sorted.back();
+    return summary;
+}
+
+std::vector<int> RollingStats::histogram(double bucketWidth, int numBuckets)
+{
+    std::vector<int> counts(numBuckets);
+    for (int i = 0; i < m_count; i++) {
+        int bucket = static_cast<int>(std::max(0.0, m_values[i] / bucketWidth));
+        counts[std::min(bucket, numBuckets - 1)]++;
+    }
+    return counts;
+}
+
+void Telemetry::addPresentedFrame(const AnalysisFrame& frame, bool newFrame, double frameSeconds, double presentTime)
+{
+    m_presentedFrames++;
+    m_frameTime.add(1e3 * frameSeconds);
+    // Before the first analysis frame there is nothing on screen to be
+    // late.
+    if (frame.newestSampleTime > 0) {
+        m_latency.add(1e3 * (presentTime - frame.newestSampleTime));
+    }
+    if (newFrame) {
+        m_analysisTime.add(1e3 * frame.analysisSeconds);
+    }
+    m_ingressStats = frame.ingressStats;
+}
+
+std::string Telemetry::getSummary()
+{
+    RollingStats::Summary latency = m_latency.summarize();
+    RollingStats::Summary frameTime = m_frameTime.summarize();
+    char summary[256];
+    std::snprintf(
+        summary, sizeof(summary),
+        "latency p50 %.1f p99 %.1f ms, frame %.1f ms, xruns %llu",
+        latency.p50, latency.p99, frameTime.p50,
+        static_cast<unsigned long long>(m_ingressStats.inputOverflows + m_ingressStats.overruns));
+    return summary;
+}
+
+static void writeSummary(std::ostream& stream, const RollingStats::Summary& summary)
+{
+    stream << "{\"count\": " << summary.count
+           << ", \"mean\": " << summary.mean
+           << ", \"p50\": " << summary.p50
+           << ", \"p90\": " << summary.p90
+           << ", \"p99\": " << summary.p99
+           << ", \"max\": " << summary.max << "}";
+}
+
+void Telemetry::writeJSON(std::ostream& stream)
+{
+    const IngressStats& ingress = m_ingressStats;
+    double meanCallbackSeconds = ingress.callbacks > 0 ? ingress.callbackSeconds / ingress.callbacks : 0;
+
+    stream << "{\n  \"presented_frames\": " << m_presentedFrames << ",\n";
+    stream << "  \"latency_ms\": ";
+    writeSummary(stream, m_latency.summarize());
+    stream << ",\n  \"latency_histogram\": {\"bucket_ms\": " << k_bucketMilliseconds << ", \"counts\": [";
+    std::vector<int> counts = m_latency.histogram(k_bucketMilliseconds, k_numBuckets);
+    for (int i = 0; i < k_numBuckets; i++) {
+        stream << (i > 0 ? ", " : "") << counts[i];
+    }
+    stream << "]},\n  \"frame_ms\": ";
+    writeSummary(stream, m_frameTime.summarize());
+    stream << ",\n  \"analysis_ms\": ";
+    writeSummary(stream, m_analysisTime.summarize());
+    stream << ",\n  \"callback\": {\"count\": " << ingress.callbacks
+           << ", \"mean_ms\": " << 1e3 * meanCallbackSeconds
+           << ", \"max_ms\": " << 1e3 * ingress.maxCallbackSeconds << "},\n";
+    stream << "  \"xruns\": {\"input_overflows\": " << ingress.inputOverflows
+           << ", \"overruns\": " << ingress.overruns
+           << ", \"dropped_frames\": " << ingress.droppedFrames << "}\n}\n";
+}
+
+void Telemetry::writeJSONFile(const std::string& path)
+{
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath);
+        if (!file) {
+            throw std::runtime_error("Could not write " + temporaryPath);
+        }
+        writeJSON(file);
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Could not write " + temporaryPath);
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Could not replace " + path);
+    }
+}
+
+void reportIngressStats(const IngressStats& stats, IngressStats& lastReported)
+{
+    if (stats.droppedFrames == lastReported.droppedFrames
+        && stats.inputOverflows == lastReported.inputOverflows) {
+        return;
+    }
+    std::cerr << "Audio input is losing data: "
+              << stats.droppedFrames << " frames dropped in "
+              << stats.overruns << " overruns, "
+              << stats.inputOverflows << " input overflows" << std::endl;
+    lastReported = stats;
+}
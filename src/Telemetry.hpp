@@ -0,0 +1,70 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Analyzer.hpp"
+
+// The last k_capacity values of a measurement, for percentiles and a
+// histogram over a recent window rather than the whole run.
+class RollingStats {
+public:
+    struct Summary {
+        int count = 0;
+        double mean = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    RollingStats();
+
+    void add(double value);
+    Summary summarize();
+    // Counts of the values in [i * bucketWidth, (i + 1) * bucketWidth), the
+    // last bucket also taking everything above it.
+    std::vector<int> histogram(double bucketWidth, int numBuckets);
+
+private:
+    static const int k_capacity = 1024;
+
+    std::vector<double> m_values;
+    int m_next = 0;
+    int m_count = 0;
+    std::vector<double> m_sorted;
+};
+
+// Render thread. Follows how stale the spectrum on screen is: for every
+// presented frame, the time from the ADC capturing the newest sample the
+// spectrum was made from to the buffer swap that put it on screen. Also
+// keeps the render and analysis times and the audio callback's stats, and
+// reports them as one line for the window title or as JSON.
+class Telemetry {
+public:
+    // frameSeconds is the time spent rendering, presentTime when the
+    // buffer swap returned. newFrame says whether the analysis frame
+    // arrived since the last call.
+    void addPresentedFrame(const AnalysisFrame& frame, bool newFrame, double frameSeconds, double presentTime);
+
+    std::string getSummary();
+    void writeJSON(std::ostream& stream);
+    // Writes the JSON to a temporary file next to path and renames it over
+    // path, so readers never see half of it.
+    void writeJSONFile(const std::string& path);
+
+private:
+    // The latency histogram's buckets, k_bucketMilliseconds wide each.
+    static const int k_bucketMilliseconds = 2;
+    static const int k_numBuckets = 50;
+
+    RollingStats m_latency;
+    RollingStats m_frameTime;
+    RollingStats m_analysisTime;
+    IngressStats m_ingressStats;
+    uint64_t m_presentedFrames = 0;
+};
+
+// Warns on stderr if the audio input lost data since lastReported, then
+// updates lastReported.
+void reportIngressStats(const IngressStats& stats, IngressStats& lastReported);
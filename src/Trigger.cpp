@@ -0,0 +1,126 @@
+#include "Trigger.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+Trigger::Trigger(int numChannels, const TriggerSettings& settings)
+    : m_numChannels(numChannels)
+    , m_settings(settings)
+    , m_captureFrames(settings.preTriggerFrames + settings.postTriggerFrames)
+    , m_preTrigger(std::max(1, settings.preTriggerFrames) * numChannels, 0)
+    , m_preTriggerRate(std::max(
+          1, (settings.preTriggerFrames + settings.postTriggerFrames - 1) / std::max(1, settings.postTriggerFrames)))
+    , m_captures(makeEmptyCapture(numChannels, m_captureFrames))
+    , m_triggers(0)
+    , m_missedTriggers(0)
+    , m_unreadCaptures(0)
+{
+    if (settings.channel < 0 || settings.channel >= numChannels) {
+        throw std::runtime_error("Trigger channel does not exist");
+    }
+    if (settings.preTriggerFrames < 0 || settings.postTriggerFrames < 1) {
+        throw std::runtime_error("Trigger capture must include the triggering frame");
+    }
+}
+
+TriggerCapture Trigger::makeEmptyCapture(int numChannels, int numFrames)
+{
+    TriggerCapture capture;
+    capture.frames.resize(numFrames * numChannels, 0);
+    return capture;
+}
+
+TriggerStats Trigger::getStats()
+{
+    TriggerStats stats;
+    stats.triggers = m_triggers.load(std::memory_order_relaxed);
+    stats.missedTriggers = m_missedTriggers.load(std::memory_order_relaxed);
+    stats.unreadCaptures = m_unreadCaptures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Trigger::startCapture(const float* frame)
+{
+    TriggerCapture& capture = m_captures.getWriteBuffer();
+    capture.triggerFrame = m_frame;
+
+    // The oldest frame in the ring is the next one it overwrites.
+    m_preTriggerStart = m_preTriggerPos;
+    m_preTriggerCopied = 0;
+    m_captured = m_settings.preTriggerFrames;
+    m_capturing = true;
+    appendToCapture(frame);
+}
+
+void Trigger::appendToCapture(const float* frame)
+{
+    TriggerCapture& capture = m_captures.getWriteBuffer();
+    std::copy(frame, frame + m_numChannels, capture.frames.begin() + m_captured * m_numChannels);
+    m_captured++;
+    copyPreTrigger(m_preTriggerRate);
+    if (m_captured == m_captureFrames) {
+        m_capturing = false;
+        if (m_captures.publish()) {
+            m_unreadCaptures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Copies the next numFrames frames of history into the capture. Called
+// before the ring takes in the current frame, which replaces the oldest
+// frame not yet copied only after that frame is copied.
+void Trigger::copyPreTrigger(int numFrames)
+{
+    TriggerCapture& capture = m_captures.getWriteBuffer();
+    int preTriggerFrames = m_settings.preTriggerFrames;
+    numFrames = std::min(numFrames, preTriggerFrames - m_preTriggerCopied);
+    while (numFrames > 0) {
+        int source = (m_preTriggerStart + m_preTriggerCopied) % preTriggerFrames;
+        int count = std::min(numFrames, preTriggerFrames - source);
+        std::copy(
+            m_preTrigger.begin() + source * m_numChannels,
+            m_preTrigger.begin() + (source + count) * m_numChannels,
+            capture.frames.begin() + m_preTriggerCopied * m_numChannels);
+        m_preTriggerCopied += count;
+        numFrames -= count;
+    }
+}
+
+void Trigger::process(const float* interleaved, int numFrames)
+{
+    // A falling edge is a rising edge of the negated signal.
+    float sign = m_settings.edge == TriggerEdge::Rising ? 1 : -1;
+    float level = sign * m_settings.level;
+    float armLevel = level - m_settings.hysteresis;
+
+    for (int i = 0; i < numFrames; i++, m_frame++) {
+        const float* frame = interleaved + i * m_numChannels;
+        if (m_capturing) {
+            appendToCapture(frame);
+        }
+
+        float sample = sign * frame[m_settings.channel];
+        if (m_holdoffRemaining > 0) {
+            m_holdoffRemaining--;
+        }
+        if (!m_armed) {
+            m_armed = sample < armLevel;
+        } else if (sample >= level) {
+            m_armed = false;
+            if (m_holdoffRemaining == 0) {
+                if (m_capturing) {
+                    m_missedTriggers.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    m_triggers.fetch_add(1, std::memory_order_relaxed);
+                    m_holdoffRemaining = m_settings.holdoff;
+                    startCapture(frame);
+                }
+            }
+        }
+
+        if (m_settings.preTriggerFrames > 0) {
+            std::copy(frame, frame + m_numChannels, m_preTrigger.begin() + m_preTriggerPos * m_numChannels);
+            m_preTriggerPos = (m_preTriggerPos + 1) % m_settings.preTriggerFrames;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "TripleBuffer.hpp"
+
+enum class TriggerEdge {
+    Rising,
+    Falling
+};
+
+struct TriggerSettings {
+    int channel = 0;
+    TriggerEdge edge = TriggerEdge::Rising;
+    float level = 0;
+    // After an edge, the signal must go back this far past the level before
+    // the next edge counts, so noise around the level cannot retrigger.
+    float hysteresis = 0.01;
+    // Frames after a trigger during which edges are ignored.
+    int holdoff = 0;
+    int preTriggerFrames = 0;
+    int postTriggerFrames = 1;
+};
+
+struct TriggerCapture {
+    // Interleaved frames: preTriggerFrames before the triggering frame, then
+    // postTriggerFrames starting with it.
+    std::vector<float> frames;
+    // Frames since the Ingress started, at the triggering frame.
+    uint64_t triggerFrame = 0;
+};
+
+struct TriggerStats {
+    uint64_t triggers = 0;
+    // Edges that arrived outside the holdoff while a capture was still
+    // being filled.
+    uint64_t missedTriggers = 0;
+    // Captures replaced before the render thread picked them up.
+    uint64_t unreadCaptures = 0;
+};
+
+// Edge trigger that runs on the audio callback thread, so it sees every
+// sample however late the render thread is. Frames from just before the
+// edge come from a history ring. The capture is written in place into the
+// producer side of a triple buffer and published once its post-trigger
+// part is complete. The history is not copied all at once when the edge
+// arrives but a few frames per frame captured after it, oldest first, so
+// ahead of the ring overwriting them, and the callback's cost stays flat.
+// The render thread picks up the latest complete capture without either
+// side waiting. The callback side allocates nothing and never blocks.
+class Trigger {
+public:
+    Trigger(int numChannels, const TriggerSettings& settings);
+
+    Trigger(const Trigger& other) = delete;
+    Trigger& operator=(const Trigger& other) = delete;
+
+    const TriggerSettings& getSettings() { return m_settings; }
+
+    // Audio callback thread.
+    void process(const float* interleaved, int numFrames);
+
+    // Render thread. Returns true if a new capture arrived since the last
+    // call.
+    bool update() { return m_captures.update(); }
+    const TriggerCapture& getCapture() { return m_captures.getReadBuffer(); }
+
+    // Safe to call from any thread.
+    TriggerStats getStats();
+
+private:
+    const int m_numChannels;
+    const TriggerSettings m_settings;
+    const int m_captureFrames;
+
+    // Written by the audio callback only.
+    std::vector<float> m_preTrigger;
+    int m_preTriggerPos = 0;
+    uint64_t m_frame = 0;
+    bool m_armed = false;
+    bool m_capturing = false;
+    int m_captured = 0;
+    // Where in the ring the capture's history starts, how much of it has
+    // been copied, and how much to copy per frame to finish by the end of
+    // the capture.
+    int m_preTriggerStart = 0;
+    int m_preTriggerCopied = 0;
+    const int m_preTriggerRate;
+    int m_holdoffRemaining = 0;
+    TripleBuffer<TriggerCapture> m_captures;
+
+    // Written by the audio callback only, read rarely from elsewhere.
+    std::atomic<uint64_t> m_triggers;
+    std::atomic<uint64_t> m_missedTriggers;
+    std::atomic<uint64_t> m_unreadCaptures;
+
+    static TriggerCapture makeEmptyCapture(int numChannels, int numFrames);
+    void startCapture(const float* frame);
+    void appendToCapture(const float* frame);
+    void copyPreTrigger(int numFrames);
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+
+// Wait-free hand-off of the latest value from one producer thread to one
+// consumer thread. The producer fills getWriteBuffer() and calls publish();
+// the consumer calls update() and reads getReadBuffer(). Neither side ever
+// blocks, and the consumer always sees the most recently published value.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer(const T& initial)
+        : m_buffers { initial, initial, initial }
+        , m_shared(1)
+    {
+    }
+
+    TripleBuffer(const TripleBuffer& other) = delete;
+    TripleBuffer& operator=(const TripleBuffer& other) = delete;
+
+    // Producer side. publish() returns true if it replaced a value the
+    // consumer never picked up.
+    T& getWriteBuffer() { return m_buffers[m_writeIndex]; }
+    bool publish()
+    {
+        int old = m_shared.exchange(m_writeIndex | k_dirty, std::memory_order_acq_rel);
+        m_writeIndex = old & k_indexMask;
+        return old & k_dirty;
+    }
+
+    // Consumer side. Returns true if a new value was published since the
+    // last call.
+    bool update()
+    {
+        if (!(m_shared.load(std::memory_order_relaxed) & k_dirty)) {
+            return false;
+        }
+        int old = m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = old & k_indexMask;
+        return true;
+    }
+    T& getReadBuffer() { return m_buffers[m_readIndex]; }
+
+private:
+    static const int k_indexMask = 3;
+    static const int k_dirty = 4;
+
+    T m_buffers[3];
+    std::atomic<int> m_shared;
+    int m_writeIndex = 0;
+    int m_readIndex = 2;
+};
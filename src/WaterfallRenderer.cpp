@@ -0,0 +1,225 @@
+#include "WaterfallRenderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+static const char* k_vertexShaderSource = ("#version 140\n"
+                                           "out vec2 position;\n"
+                                           "void main()\n"
+                                           "{\n"
+                                           "    position = vec2(gl_VertexID % 2, gl_VertexID / 2);\n"
+                                           "    gl_Position = vec4(2.0 * position - 1.0, 0, 1);\n"
+                                           "}\n");
+
+// columns maps a pixel column to the horizontal texture coordinate of the
+// chunks around it, so chunks, which are not evenly spaced, are
+// interpolated linearly by the texture unit. newest.x is the vertical
+// texture coordinate of the newest row's center and newest.y the distance
+// from it down to the oldest row's center, wrapping around the ring.
+static const char* k_fragmentShaderSource = ("#version 140\n"
+                                             "uniform sampler2D history;\n"
+                                             "uniform sampler1D columns;\n"
+                                             "uniform sampler1D palette;\n"
+                                             "uniform vec2 newest;\n"
+                                             "uniform vec2 range;\n"
+                                             "in vec2 position;\n"
+                                             "out vec4 fragColor;\n"
+                                             "void main()\n"
+                                             "{\n"
+                                             "    float u = texture(columns, position.x).r;\n"
+                                             "    float v = newest.x - (1.0 - position.y) * newest.y;\n"
+                                             "    float level = texture(history, vec2(u, v)).r;\n"
+                                             "    fragColor = texture(palette, clamp((level - range.x) / (range.y - range.x), 0.0, 1.0));\n"
+                                             "}\n");
+
+// From the background color through the channel colors to white.
+static const std::array<int, 6> k_paletteStops = { {
+    0x1d1f21,
+    0x373b41,
+    0x81a2be,
+    0xb294bb,
+    0xf0c674,
+    0xffffff,
+} };
+
+static const int k_paletteSize = 256;
+static const float k_silence = -1000;
+
+WaterfallRenderer::WaterfallRenderer(Spectrum& spectrum, int historyRows)
+    : m_spectrum(spectrum)
+{
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    m_historyRows = std::max(2, std::min(historyRows, static_cast<int>(maxTextureSize)));
+
+    m_shaderProgram.reset(new ShaderProgram(k_vertexShaderSource, k_fragmentShaderSource));
+    m_program = m_shaderProgram->getProgram();
+    m_historyLocation = glGetUniformLocation(m_program, "history");
+    m_columnsLocation = glGetUniformLocation(m_program, "columns");
+    m_paletteLocation = glGetUniformLocation(m_program, "palette");
+    m_newestLocation = glGetUniformLocation(m_program, "newest");
+    m_rangeLocation = glGetUniformLocation(m_program, "range");
+
+    // The quad's corners come from gl_VertexID, but a VAO must be bound to
+    // draw in a core profile.
+    glGenVertexArrays(1, &m_vao);
+
+    glGenTextures(1, &m_historyTexture);
+    glBindTexture(GL_TEXTURE_2D, m_historyTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glGenFramebuffers(1, &m_historyFramebuffer);
+
+    glGenTextures(1, &m_columnsTexture);
+    glBindTexture(GL_TEXTURE_1D, m_columnsTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &m_paletteTexture);
+    glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    makePalette();
+}
+
+WaterfallRenderer::~WaterfallRenderer()
+{
+    glDeleteFramebuffers(1, &m_historyFramebuffer);
+    glDeleteTextures(1, &m_historyTexture);
+    glDeleteTextures(1, &m_columnsTexture);
+    glDeleteTextures(1, &m_paletteTexture);
+    glDeleteVertexArrays(1, &m_vao);
+}
+
+bool WaterfallRenderer::isSupported()
+{
+    return GLEW_VERSION_3_1;
+}
+
+void WaterfallRenderer::makePalette()
+{
+    std::vector<unsigned char> palette(4 * k_paletteSize);
+    int numSegments = k_paletteStops.size() - 1;
+    for (int i = 0; i < k_paletteSize; i++) {
+        float position = static_cast<float>(i) / (k_paletteSize - 1) * numSegments;
+        int segment = std::min(static_cast<int>(position), numSegments - 1);
+        float t = position - segment;
+        for (int component = 0; component < 3; component++) {
+            int shift = 8 * (2 - component);
+            float from = k_paletteStops[segment] >> shift & 0xff;
+            float to = k_paletteStops[segment + 1] >> shift & 0xff;
+            palette[4 * i + component] = static_cast<unsigned char>(from + (to - from) * t + 0.5f);
+        }
+        palette[4 * i + 3] = 255;
+    }
+    glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, k_paletteSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette.data());
+}
+
+// The texture only grows, so after the widest layout so far, a change in
+// the number of chunks just clears the history.
+void WaterfallRenderer::resizeHistory()
+{
+    m_numChunks = m_spectrum.getChunkY().size();
+    m_columnsWidth = 0;
+    if (m_numChunks == 0) {
+        return;
+    }
+    if (m_numChunks > m_historyWidth) {
+        m_historyWidth = m_numChunks;
+        glBindTexture(GL_TEXTURE_2D, m_historyTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_historyWidth, m_historyRows, 0, GL_RED, GL_FLOAT, nullptr);
+    }
+    clearHistory();
+}
+
+// Fills the history with silence on the GPU, so no copy of it is kept
+// around to upload. R32F is color-renderable from OpenGL 3.0, so the
+// framebuffer fallback works everywhere the waterfall does.
+void WaterfallRenderer::clearHistory()
+{
+    if (GLEW_ARB_clear_texture) {
+        glClearTexImage(m_historyTexture, 0, GL_RED, GL_FLOAT, &k_silence);
+        return;
+    }
+    GLint targetFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_historyFramebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_historyTexture, 0);
+    const float silence[4] = { k_silence, 0, 0, 0 };
+    glClearBufferfv(GL_COLOR, 0, silence);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+}
+
+void WaterfallRenderer::updateColumns(int width)
+{
+    const std::vector<float>& chunkX = m_spectrum.getChunkX();
+    m_columns.resize(width);
+    int chunk = 0;
+    for (int i = 0; i < width; i++) {
+        float x = (i + 0.5f) / width;
+        while (chunk < m_numChunks - 1 && chunkX[chunk + 1] <= x) {
+            chunk++;
+        }
+        float position = chunk;
+        if (chunk < m_numChunks - 1) {
+            position += std::max(0.0f, (x - chunkX[chunk]) / (chunkX[chunk + 1] - chunkX[chunk]));
+        }
+        m_columns[i] = (position + 0.5f) / m_historyWidth;
+    }
+    glBindTexture(GL_TEXTURE_1D, m_columnsTexture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, width, 0, GL_RED, GL_FLOAT, m_columns.data());
+    m_columnsWidth = width;
+}
+
+void WaterfallRenderer::render(RangeComputer& rangeComputer)
+{
+    const std::vector<float>& chunkY = m_spectrum.getChunkY();
+    if (static_cast<int>(chunkY.size()) != m_numChunks) {
+        resizeHistory();
+    }
+    // The column lookup follows the Spectrum's layout; between layouts it
+    // is stretched over the viewport like the chunks themselves.
+    int width = m_spectrum.getWindowWidth();
+    if (m_numChunks == 0 || width < 1) {
+        return;
+    }
+    if (width != m_columnsWidth) {
+        updateColumns(width);
+    }
+
+    m_newestRow = (m_newestRow + 1) % m_historyRows;
+    glBindTexture(GL_TEXTURE_2D, m_historyTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_newestRow, m_numChunks, 1, GL_RED, GL_FLOAT, chunkY.data());
+
+    glUseProgram(m_program);
+    glBindVertexArray(m_vao);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_historyTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, m_columnsTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(m_historyLocation, 0);
+    glUniform1i(m_columnsLocation, 1);
+    glUniform1i(m_paletteLocation, 2);
+    // From the center of the newest row at the top down to the center of
+    // the oldest at the bottom, so filtering never blends across the seam.
+    glUniform2f(
+        m_newestLocation,
+        (m_newestRow + 0.5f) / m_historyRows,
+        (m_historyRows - 1.0f) / m_historyRows);
+    glUniform2f(m_rangeLocation, rangeComputer.getBottom(), rangeComputer.getTop());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindVertexArray(0);
+}
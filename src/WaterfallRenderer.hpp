@@ -0,0 +1,65 @@
+#pragma once
+#include <GL/glew.h>
+#include <memory>
+#include <vector>
+
+#include "FFT.hpp"
+#include "ShaderProgram.hpp"
+#include "Spectrum.hpp"
+
+// A scrolling spectrogram of a Spectrum's smoothed chunk levels, newest row
+// at the top. History lives in a ring of rows of an R32F texture. Each
+// render() uploads the Spectrum's chunk levels as one row, straight from
+// its vector, with one glTexSubImage2D. The fragment shader turns screen y
+// into an age and offsets the row coordinate by the write position, so no
+// history is moved. It maps dB to color through a 1D palette texture. Cost
+// per frame is one row and one fullscreen quad, whatever the history
+// length. Needs OpenGL 3.1.
+class WaterfallRenderer {
+public:
+    // The spectrum must outlive the renderer. historyRows is capped at the
+    // largest texture the context supports.
+    WaterfallRenderer(Spectrum& spectrum, int historyRows);
+    ~WaterfallRenderer();
+
+    WaterfallRenderer(const WaterfallRenderer& other) = delete;
+    WaterfallRenderer& operator=(const WaterfallRenderer& other) = delete;
+
+    static bool isSupported();
+    int getHistoryRows() { return m_historyRows; }
+
+    // Adds the Spectrum's current chunks as the newest row and draws the
+    // history into the current viewport. The history is cleared when the
+    // Spectrum's number of chunks changes.
+    void render(RangeComputer& rangeComputer);
+
+private:
+    Spectrum& m_spectrum;
+    int m_historyRows;
+    int m_numChunks = 0;
+    // Width of the history texture, at least m_numChunks.
+    int m_historyWidth = 0;
+    std::vector<float> m_columns;
+    int m_columnsWidth = 0;
+    int m_newestRow = 0;
+
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    GLuint m_program;
+    GLint m_historyLocation;
+    GLint m_columnsLocation;
+    GLint m_paletteLocation;
+    GLint m_newestLocation;
+    GLint m_rangeLocation;
+
+    GLuint m_vao;
+    GLuint m_historyTexture;
+    // Clears the history where glClearTexImage() is missing.
+    GLuint m_historyFramebuffer;
+    GLuint m_columnsTexture;
+    GLuint m_paletteTexture;
+
+    void makePalette();
+    void resizeHistory();
+    void clearHistory();
+    void updateColumns(int width);
+};
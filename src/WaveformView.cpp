@@ -0,0 +1,145 @@
+#include "WaveformView.hpp"
+#include "Colors.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+static const char* k_vertexShaderSource = ("#version 120\n"
+                                           "attribute vec2 pos;\n"
+                                           "void main()\n"
+                                           "{\n"
+                                           "    gl_Position = vec4(pos, 1, 1);\n"
+                                           "}\n");
+
+static const char* k_fragmentShaderSource = ("#version 120\n"
+                                             "uniform vec4 color;\n"
+                                             "void main()\n"
+                                             "{\n"
+                                             "    gl_FragColor = color;\n"
+                                             "}\n");
+
+static const float k_thicknessInPixels = 1.5;
+
+WaveformView::WaveformView(SPSCRing& tap, int numChannels, float sampleRate, float spanSeconds)
+    : m_numChannels(numChannels)
+    , m_span(spanSeconds * sampleRate)
+    , m_tap(tap)
+    , m_pyramid(numChannels, std::max(1, static_cast<int>(m_span)))
+    , m_readBuffer(k_readSize * numChannels)
+    , m_silence(k_readSize * numChannels, 0)
+{
+    m_shaderProgram.reset(new ShaderProgram(k_vertexShaderSource, k_fragmentShaderSource));
+    m_program = m_shaderProgram->getProgram();
+    m_colorLocation = glGetUniformLocation(m_program, "color");
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glGenBuffers(1, &m_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    GLint pos = m_shaderProgram->getAttribLocation("pos");
+    glVertexAttribPointer(pos, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(pos);
+    glBindVertexArray(0);
+}
+
+WaveformView::~WaveformView()
+{
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteVertexArrays(1, &m_vao);
+}
+
+void WaveformView::drainTap()
+{
+    while (true) {
+        uint64_t droppedFrames = 0;
+        int numFrames = m_tap.read(m_readBuffer.data(), k_readSize, droppedFrames);
+        // Fill what was lost with silence, so the trace keeps its timing.
+        if (droppedFrames > 0) {
+            uint64_t remaining = std::min<uint64_t>(droppedFrames, m_pyramid.getCapacity());
+            while (remaining > 0) {
+                int numSilent = std::min<uint64_t>(remaining, k_readSize);
+                m_pyramid.push(m_silence.data(), numSilent);
+                remaining -= numSilent;
+            }
+        }
+        if (numFrames == 0) {
+            return;
+        }
+        m_pyramid.push(m_readBuffer.data(), numFrames);
+    }
+}
+
+void WaveformView::reduceCapture(int width)
+{
+    const std::vector<float>& frames = m_trigger->getCapture().frames;
+    int numFrames = frames.size() / m_numChannels;
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        float* minima = &m_minima[channel * width];
+        float* maxima = &m_maxima[channel * width];
+        for (int i = 0; i < width; i++) {
+            int first = static_cast<int64_t>(i) * numFrames / width;
+            int end = std::max(first + 1, static_cast<int>(static_cast<int64_t>(i + 1) * numFrames / width));
+            minima[i] = maxima[i] = frames[first * m_numChannels + channel];
+            for (int frame = first + 1; frame < end; frame++) {
+                float sample = frames[frame * m_numChannels + channel];
+                minima[i] = std::min(minima[i], sample);
+                maxima[i] = std::max(maxima[i], sample);
+            }
+        }
+    }
+    m_captureWidth = width;
+}
+
+void WaveformView::render(int y, int width, int height)
+{
+    drainTap();
+    if (width < 1 || height < 1) {
+        return;
+    }
+
+    m_minima.resize(m_numChannels * width);
+    m_maxima.resize(m_numChannels * width);
+    if (m_trigger) {
+        if (m_trigger->update() || width != m_captureWidth) {
+            reduceCapture(width);
+        }
+    } else {
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            m_pyramid.getColumns(channel, m_span, width, &m_minima[channel * width], &m_maxima[channel * width]);
+        }
+    }
+
+    m_vertices.resize(m_numChannels * 4 * width);
+    float halfThickness = k_thicknessInPixels / height;
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        const float* minima = &m_minima[channel * width];
+        const float* maxima = &m_maxima[channel * width];
+        float* vertices = &m_vertices[channel * 4 * width];
+        for (int i = 0; i < width; i++) {
+            float minimum = minima[i];
+            float maximum = maxima[i];
+            // Overlap the previous column, so steep edges stay connected.
+            if (i > 0) {
+                minimum = std::min(minimum, maxima[i - 1]);
+                maximum = std::max(maximum, minima[i - 1]);
+            }
+            float x = 2 * (i + 0.5f) / width - 1;
+            vertices[4 * i + 0] = x;
+            vertices[4 * i + 1] = std::min(maximum, 1.0f) + halfThickness;
+            vertices[4 * i + 2] = x;
+            vertices[4 * i + 3] = std::max(minimum, -1.0f) - halfThickness;
+        }
+    }
+
+    glViewport(0, y, width, height);
+    glUseProgram(m_program);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STREAM_DRAW);
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        std::array<float, 4> color = channelColor(channel, 0.8);
+        glUniform4fv(m_colorLocation, 1, color.data());
+        glDrawArrays(GL_TRIANGLE_STRIP, channel * 2 * width, 2 * width);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <GL/glew.h>
+#include <memory>
+#include <vector>
+
+#include "MinMaxPyramid.hpp"
+#include "SPSCRing.hpp"
+#include "ShaderProgram.hpp"
+#include "Trigger.hpp"
+
+// Oscilloscope view of the newest spanSeconds of every channel, drawn over
+// each other in the channel colors. Audio arrives through a ring passed to
+// Analyzer::addTap() and is kept in a MinMaxPyramid on the render thread.
+// Each frame reads one minimum/maximum pair per pixel column from it and
+// draws every channel as one triangle strip between them, so a 30 second
+// span costs no more to draw than a 5 millisecond one. With a Trigger, the
+// view instead holds still on the trigger's latest capture, reduced to
+// columns once when it arrives.
+class WaveformView {
+public:
+    // The tap must outlive the view.
+    WaveformView(SPSCRing& tap, int numChannels, float sampleRate, float spanSeconds);
+    ~WaveformView();
+
+    WaveformView(const WaveformView& other) = delete;
+    WaveformView& operator=(const WaveformView& other) = delete;
+
+    // Show the trigger's captures instead of the newest audio. The trigger
+    // must outlive the view.
+    void setTrigger(Trigger& trigger) { m_trigger = &trigger; }
+
+    // Takes in the audio that arrived since the last call and draws into
+    // window rows [y, y + height).
+    void render(int y, int width, int height);
+
+private:
+    // Frames read from the tap at a time.
+    static const int k_readSize = 4096;
+
+    const int m_numChannels;
+    const double m_span;
+    SPSCRing& m_tap;
+    MinMaxPyramid m_pyramid;
+    Trigger* m_trigger = nullptr;
+    // Width the trigger capture was last reduced to.
+    int m_captureWidth = 0;
+    std::vector<float> m_readBuffer;
+    // k_readSize frames of zeros, pushed in place of dropped audio.
+    std::vector<float> m_silence;
+    // [channel][column]
+    std::vector<float> m_minima;
+    std::vector<float> m_maxima;
+    std::vector<float> m_vertices;
+
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    GLuint m_program;
+    GLint m_colorLocation;
+    GLuint m_vao;
+    GLuint m_vbo;
+
+    void drainTap();
+    void reduceCapture(int width);
+};
@@ -0,0 +1,201 @@
+#include "ZoomFFT.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const double k_pi = 3.14159265358979;
+
+ZoomFFT::ZoomFFT(
+    float centerFrequency,
+    float span,
+    int fftSize,
+    int numChannels,
+    float sampleRate,
+    float overlapPercent,
+    int referenceFFTSize,
+    PlanEffort planEffort)
+    : m_centerFrequency(centerFrequency)
+    , m_span(span)
+    , m_fftSize(fftSize)
+    , m_numChannels(numChannels)
+    // Leave the decimated stream at least 1.5 times the span, so the
+    // anti-aliasing filter has half a span to roll off in.
+    , m_decimationFactor(std::max(1, static_cast<int>(sampleRate / (1.5f * span))))
+    , m_decimatedHopSize(std::max(1, static_cast<int>(std::round(fftSize * (1 - overlapPercent / 100)))))
+    , m_blockMixerReal(k_blockSize)
+    , m_blockMixerImag(k_blockSize)
+{
+    if (span <= 0 || centerFrequency - span / 2 <= 0 || centerFrequency + span / 2 >= sampleRate / 2) {
+        throw std::runtime_error("Zoom range must lie between 0 Hz and Nyquist");
+    }
+    if (overlapPercent < 0 || overlapPercent >= 100) {
+        throw std::runtime_error("Overlap must be at least 0% and less than 100%.");
+    }
+
+    double step = -2 * k_pi * centerFrequency / sampleRate;
+    m_mixerStepReal = std::cos(step);
+    m_mixerStepImag = std::sin(step);
+
+    float decimatedRate = sampleRate / m_decimationFactor;
+    makeTaps((decimatedRate - span) / sampleRate);
+    m_mixedReal.resize(m_numChannels * 2 * m_numTaps);
+    m_mixedImag.resize(m_numChannels * 2 * m_numTaps);
+
+    m_decimated.resize(m_numChannels * 2 * m_fftSize * 2);
+
+    m_window.resize(m_fftSize);
+    for (int i = 0; i < m_fftSize; i++) {
+        float t = static_cast<float>(i) / m_fftSize;
+        m_window[i] = (-std::cos(t * 2 * k_pi) + 1) * 0.5;
+    }
+
+    m_fftInput = static_cast<FFTComplex*>(FFTW(malloc)(sizeof(FFTComplex) * m_fftSize * m_numChannels));
+    m_fftOutput = static_cast<FFTComplex*>(FFTW(malloc)(sizeof(FFTComplex) * m_fftSize * m_numChannels));
+    m_fftwPlan = FFTW(plan_many_dft)(
+        1, &m_fftSize, m_numChannels,
+        m_fftInput, nullptr, 1, m_fftSize,
+        m_fftOutput, nullptr, 1, m_fftSize,
+        FFTW_FORWARD, planFlags(planEffort));
+    for (int i = 0; i < m_fftSize * m_numChannels; i++) {
+        m_fftInput[i][0] = 0;
+        m_fftInput[i][1] = 0;
+    }
+
+    float binWidth = decimatedRate / m_fftSize;
+    int halfSpanBins = std::min(static_cast<int>(span / 2 / binWidth), m_fftSize / 2 - 1);
+    m_firstShiftedBin = m_fftSize / 2 - halfSpanBins;
+    m_numBins = 2 * halfSpanBins + 1;
+    for (int i = 0; i < m_numBins; i++) {
+        m_binFrequencies.push_back(centerFrequency + (i - halfSpanBins) * binWidth);
+    }
+    m_magnitudes.resize(m_numChannels * m_numBins, -1000);
+
+    // Mixing halves a real sine's amplitude, and the FFT is complex, so a
+    // sine reads 20 log10(A fftSize / 4) just like the real FFT path.
+    m_gainDb = 20 * std::log10(static_cast<float>(referenceFFTSize) / m_fftSize);
+}
+
+ZoomFFT::~ZoomFFT()
+{
+    FFTW(destroy_plan)(m_fftwPlan);
+    FFTW(free)(m_fftInput);
+    FFTW(free)(m_fftOutput);
+}
+
+void ZoomFFT::makeTaps(float transitionWidth)
+{
+    if (m_decimationFactor == 1) {
+        m_numTaps = 1;
+        m_taps.assign(1, 1);
+        return;
+    }
+
+    // Blackman-windowed sinc cut off at half the decimated rate. A Blackman
+    // window's transition is about 5.5 / numTaps wide.
+    m_numTaps = static_cast<int>(std::ceil(5.5f / transitionWidth)) | 1;
+    float cutoff = 0.5f / m_decimationFactor;
+    m_taps.resize(m_numTaps);
+    float sum = 0;
+    for (int i = 0; i < m_numTaps; i++) {
+        double x = i - (m_numTaps - 1) / 2.0;
+        double sinc = x == 0 ? 1 : std::sin(2 * k_pi * cutoff * x) / (2 * k_pi * cutoff * x);
+        double t = static_cast<double>(i) / (m_numTaps - 1);
+        double blackman = 0.42 - 0.5 * std::cos(2 * k_pi * t) + 0.08 * std::cos(4 * k_pi * t);
+        m_taps[i] = sinc * blackman;
+        sum += m_taps[i];
+    }
+    for (int i = 0; i < m_numTaps; i++) {
+        m_taps[i] /= sum;
+    }
+}
+
+bool ZoomFFT::process(Ingress& ingress, int frameCount, uint64_t droppedFrames)
+{
+    // Only the frames the read added are mixed in. Dropped frames are gone,
+    // and the decimated stream simply carries on from the newest ones.
+    decimate(ingress, frameCount);
+    if (m_decimatedSinceTransform < m_decimatedHopSize) {
+        return false;
+    }
+    m_decimatedSinceTransform -= m_decimatedHopSize;
+    transform();
+    return true;
+}
+
+void ZoomFFT::decimate(Ingress& ingress, int frameCount)
+{
+    for (int i = 0; i < frameCount; i++) {
+        m_blockMixerReal[i] = m_mixerReal;
+        m_blockMixerImag[i] = m_mixerImag;
+        double real = m_mixerReal * m_mixerStepReal - m_mixerImag * m_mixerStepImag;
+        m_mixerImag = m_mixerReal * m_mixerStepImag + m_mixerImag * m_mixerStepReal;
+        m_mixerReal = real;
+    }
+    // Keep the phasor from drifting off the unit circle.
+    double magnitude = std::sqrt(m_mixerReal * m_mixerReal + m_mixerImag * m_mixerImag);
+    m_mixerReal /= magnitude;
+    m_mixerImag /= magnitude;
+
+    for (int i = 0; i < frameCount; i++) {
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            float sample = ingress.getHistory(channel, frameCount)[i];
+            int index = channel * 2 * m_numTaps + m_tapPos;
+            m_mixedReal[index] = m_mixedReal[index + m_numTaps] = sample * m_blockMixerReal[i];
+            m_mixedImag[index] = m_mixedImag[index + m_numTaps] = sample * m_blockMixerImag[i];
+        }
+        m_tapPos = (m_tapPos + 1) % m_numTaps;
+
+        m_decimationPhase++;
+        if (m_decimationPhase < m_decimationFactor) {
+            continue;
+        }
+        m_decimationPhase = 0;
+
+        for (int channel = 0; channel < m_numChannels; channel++) {
+            const float* real = &m_mixedReal[channel * 2 * m_numTaps + m_tapPos];
+            const float* imag = &m_mixedImag[channel * 2 * m_numTaps + m_tapPos];
+            float outputReal = 0;
+            float outputImag = 0;
+            for (int k = 0; k < m_numTaps; k++) {
+                outputReal += m_taps[k] * real[k];
+                outputImag += m_taps[k] * imag[k];
+            }
+            float* decimated = &m_decimated[channel * 4 * m_fftSize];
+            decimated[2 * m_decimatedPos] = decimated[2 * (m_decimatedPos + m_fftSize)] = outputReal;
+            decimated[2 * m_decimatedPos + 1] = decimated[2 * (m_decimatedPos + m_fftSize) + 1] = outputImag;
+        }
+        m_decimatedPos = (m_decimatedPos + 1) % m_fftSize;
+        m_decimatedSinceTransform++;
+    }
+}
+
+void ZoomFFT::transform()
+{
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        const float* decimated = &m_decimated[channel * 4 * m_fftSize + 2 * m_decimatedPos];
+        FFTComplex* input = m_fftInput + channel * m_fftSize;
+        for (int i = 0; i < m_fftSize; i++) {
+            input[i][0] = decimated[2 * i] * m_window[i];
+            input[i][1] = decimated[2 * i + 1] * m_window[i];
+        }
+    }
+
+    FFTW(execute)(m_fftwPlan);
+
+    // Shifted bin j holds FFT bin (j + fftSize / 2) mod fftSize, so the span
+    // is a run of negative-frequency bins at the top of the FFT output
+    // followed by a run of non-negative ones at the bottom.
+    int numNegative = m_fftSize / 2 - m_firstShiftedBin;
+    for (int channel = 0; channel < m_numChannels; channel++) {
+        const FFTComplex* output = m_fftOutput + channel * m_fftSize;
+        float* magnitudes = &m_magnitudes[channel * m_numBins];
+        simd::magnitudeToDb(
+            reinterpret_cast<const FFTReal*>(output + m_fftSize - numNegative), magnitudes, numNegative);
+        simd::magnitudeToDb(
+            reinterpret_cast<const FFTReal*>(output), magnitudes + numNegative, m_numBins - numNegative);
+        for (int i = 0; i < m_numBins; i++) {
+            magnitudes[i] += m_gainDb;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+
+#include "AnalysisEngine.hpp"
+#include "FFT.hpp"
+
+// Narrow-band analysis of [center - span / 2, center + span / 2]. Incoming
+// audio is mixed down so the center sits at DC, low-passed and decimated by
+// a polyphase FIR that only evaluates the outputs it keeps, and the
+// decimated complex stream goes through a small complex FFT. Resolution is
+// that of an FFT decimationFactor times larger, at a fraction of its cost.
+class ZoomFFT : public AnalysisEngine {
+public:
+    ZoomFFT(
+        float centerFrequency,
+        float span,
+        int fftSize,
+        int numChannels,
+        float sampleRate,
+        float overlapPercent,
+        int referenceFFTSize,
+        PlanEffort planEffort);
+    ~ZoomFFT();
+
+    ZoomFFT(const ZoomFFT& other) = delete;
+    ZoomFFT& operator=(const ZoomFFT& other) = delete;
+
+    int getDecimationFactor() { return m_decimationFactor; }
+
+    int getHopSize() override { return k_blockSize; }
+    int getLongestWindow() override { return k_blockSize; }
+    int getNumChannels() override { return m_numChannels; }
+    const std::vector<float>& getBinFrequencies() override { return m_binFrequencies; }
+    float getLowestFrequency() override { return m_centerFrequency - m_span / 2; }
+    float getHighestFrequency() override { return m_centerFrequency + m_span / 2; }
+
+    // The mixer and decimator carry state from sample to sample.
+    bool canStartMidStream() override { return false; }
+    bool process(Ingress& ingress, int frameCount, uint64_t droppedFrames) override;
+    const std::vector<float>& getMagnitudes() override { return m_magnitudes; }
+
+private:
+    // Most input frames consumed per call to process().
+    static const int k_blockSize = 256;
+
+    const float m_centerFrequency;
+    const float m_span;
+    const int m_fftSize;
+    const int m_numChannels;
+    const int m_decimationFactor;
+    const int m_decimatedHopSize;
+    float m_gainDb;
+
+    // Mixer: a unit phasor advanced by m_mixerStep every input sample.
+    double m_mixerReal = 1;
+    double m_mixerImag = 0;
+    double m_mixerStepReal;
+    double m_mixerStepImag;
+    std::vector<float> m_blockMixerReal;
+    std::vector<float> m_blockMixerImag;
+
+    // Decimator: per channel, mirrored histories of the mixed signal, one
+    // for the real and one for the imaginary part.
+    std::vector<float> m_taps;
+    int m_numTaps;
+    std::vector<float> m_mixedReal;
+    std::vector<float> m_mixedImag;
+    int m_tapPos = 0;
+    int m_decimationPhase = 0;
+
+    // Per channel, a mirrored history of interleaved complex decimated
+    // samples.
+    std::vector<float> m_decimated;
+    int m_decimatedPos = 0;
+    int m_decimatedSinceTransform = 0;
+
+    std::vector<float> m_window;
+    FFTComplex* m_fftInput;
+    FFTComplex* m_fftOutput;
+    FFTPlan m_fftwPlan;
+
+    // Range of the FFT's shifted (negative to positive frequency) bins that
+    // fall inside the span.
+    int m_firstShiftedBin;
+    int m_numBins;
+    std::vector<float> m_binFrequencies;
+    std::vector<float> m_magnitudes;
+
+    void makeTaps(float transitionWidth);
+    void decimate(Ingress& ingress, int frameCount);
+    void transform();
+};
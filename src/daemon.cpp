@@ -0,0 +1,302 @@
+#include "daemon.hpp"
+#include "Clock.hpp"
+#include "FFTWisdom.hpp"
+#include "LiveAnalysis.hpp"
+#include "ProcessUsage.hpp"
+#include "SpectrumWriter.hpp"
+#include "SyntheticSource.hpp"
+#include "Telemetry.hpp"
+#include "portaudio_backend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+static volatile std::sig_atomic_t g_stopRequested = 0;
+static volatile std::sig_atomic_t g_reopenRequested = 0;
+
+static void requestStop(int signalNumber)
+{
+    g_stopRequested = 1;
+}
+
+static void requestReopen(int signalNumber)
+{
+    g_reopenRequested = 1;
+}
+
+// CPU and memory are sampled every k_usageInterval seconds, and CPU use is
+// checked against the budget over every k_budgetInterval.
+static const double k_usageInterval = 1;
+static const double k_budgetInterval = 10;
+// Longest sleep of the main loop, which bounds how late a signal is noticed.
+static const double k_maxSleep = 0.1;
+// A soak test fails if resident memory grows by more than this after its
+// first tenth, which leaves time for every buffer and the allocator to
+// settle.
+static const uint64_t k_soakMemoryTolerance = 1 << 20;
+
+// Stands in for the audio device in soak tests: a thread pushing blocks of
+// synthetic audio into the Ingress at speed times real time, each stamped
+// as captured when it is pushed.
+class SyntheticInput {
+public:
+    SyntheticInput(Ingress& ingress, int numChannels, float sampleRate, double speed)
+        : m_ingress(ingress)
+        , m_source(numChannels, sampleRate)
+        , m_sampleRate(sampleRate)
+        , m_speed(speed)
+        , m_block(k_blockSize * numChannels)
+        , m_frames(0)
+        , m_running(false)
+    {
+    }
+    ~SyntheticInput() { stop(); }
+
+    void start()
+    {
+        m_running = true;
+        m_thread = std::thread(&SyntheticInput::run, this);
+    }
+
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    uint64_t getFrames() { return m_frames; }
+
+private:
+    static const int k_blockSize = 256;
+
+    Ingress& m_ingress;
+    SyntheticSource m_source;
+    const float m_sampleRate;
+    const double m_speed;
+    std::vector<float> m_block;
+    std::atomic<uint64_t> m_frames;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    void run()
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t frames = 0;
+        while (m_running) {
+            m_source.generate(m_block.data(), k_blockSize);
+            m_ingress.process(m_block.data(), nullptr, k_blockSize, 0, getSteadyTime() - k_blockSize / m_sampleRate);
+            frames += k_blockSize;
+            m_frames = frames;
+            // Paced from the start rather than block to block, so sleeping
+            // late does not add up.
+            std::chrono::duration<double> due(frames / (m_sampleRate * m_speed));
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::nanoseconds>(due));
+        }
+    }
+};
+
+static double toMiB(uint64_t bytes)
+{
+    return bytes / 1048576.0;
+}
+
+// A full disk must not take the daemon down: failures are reported once
+// per streak and the next frame tries again. Only a reader that closed its
+// end of the pipe stops it, since nothing can be written after that.
+static void writeFrame(SpectrumWriter& writer, const AnalysisFrame& frame, bool& failing)
+{
+    try {
+        writer.write(frame);
+        failing = false;
+    } catch (const std::runtime_error& error) {
+        if (writer.isReaderGone()) {
+            std::cerr << "The reader of the output went away, stopping" << std::endl;
+            g_stopRequested = 1;
+            return;
+        }
+        if (!failing) {
+            std::cerr << error.what() << std::endl;
+        }
+        failing = true;
+    }
+}
+
+int runDaemon(const Options& options)
+{
+    FFTWisdom wisdom;
+    wisdom.load();
+
+    const float sampleRate = PortAudioBackend::k_sampleRate;
+
+    LiveAnalysis analysis(options, sampleRate, wisdom);
+    Ingress& ingress = analysis.getIngress();
+    Analyzer& analyzer = analysis.getAnalyzer();
+
+    // A reader of --output - that exits must not kill the daemon with
+    // SIGPIPE. Writes fail with EPIPE instead, and the daemon stops.
+    std::signal(SIGPIPE, SIG_IGN);
+    std::unique_ptr<SpectrumWriter> writer;
+    if (!options.outputPath.empty()) {
+        writer.reset(new SpectrumWriter(
+            options.outputPath,
+            analyzer.getBinFrequencies(),
+            options.numChannels,
+            sampleRate,
+            analyzer.getAccumulatorKinds()));
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::signal(SIGHUP, requestReopen);
+
+    const bool soak = options.soakSeconds > 0;
+    std::unique_ptr<SyntheticInput> syntheticInput;
+    std::unique_ptr<PortAudioBackend> audioBackend;
+    if (soak) {
+        syntheticInput.reset(new SyntheticInput(ingress, options.numChannels, sampleRate, options.soakSpeed));
+    } else {
+        audioBackend.reset(new PortAudioBackend(&ingress, options.device, options.numChannels));
+    }
+
+    analyzer.start();
+    if (syntheticInput) {
+        syntheticInput->start();
+    } else {
+        audioBackend->run();
+    }
+
+    const double startTime = getSteadyTime();
+    double nextOutput = startTime + options.outputInterval;
+    double nextUsage = startTime + k_usageInterval;
+    ProcessUsage budgetStart = ProcessUsage::measure();
+    double budgetStartTime = startTime;
+    IngressStats lastReportedStats;
+    bool outputFailing = false;
+
+    // Measured once the soak test's first tenth is over.
+    const double warmUpEnd = startTime + options.soakSeconds / 10;
+    bool warmedUp = false;
+    ProcessUsage soakStart;
+    double soakStartTime = 0;
+    uint64_t peakResidentBytes = 0;
+    double peakCPUPercent = 0;
+
+    while (!g_stopRequested) {
+        double now = getSteadyTime();
+        double wakeUp = std::min(std::min(nextOutput, nextUsage), now + k_maxSleep);
+        if (soak) {
+            wakeUp = std::min(wakeUp, startTime + options.soakSeconds);
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::max(0.0, wakeUp - now)));
+        now = getSteadyTime();
+
+        if (g_reopenRequested) {
+            g_reopenRequested = 0;
+            // A failed rotation must not stop the daemon: the frames keep
+            // going to the old file until the next SIGHUP tries again.
+            if (writer) {
+                try {
+                    writer->reopen();
+                } catch (const std::runtime_error& error) {
+                    std::cerr << error.what() << std::endl;
+                }
+            }
+        }
+
+        if (now >= nextOutput) {
+            nextOutput += options.outputInterval;
+            // After a stall, carry on from now rather than catching up.
+            if (nextOutput <= now) {
+                nextOutput = now + options.outputInterval;
+            }
+            if (analyzer.update()) {
+                const AnalysisFrame& frame = analyzer.getFrame();
+                reportIngressStats(frame.ingressStats, lastReportedStats);
+                if (writer) {
+                    writeFrame(*writer, frame, outputFailing);
+                }
+            }
+        }
+
+        if (now >= nextUsage) {
+            nextUsage = now + k_usageInterval;
+            ProcessUsage usage = ProcessUsage::measure();
+            if (soak && !warmedUp && now >= warmUpEnd) {
+                warmedUp = true;
+                soakStart = usage;
+                soakStartTime = now;
+            }
+            if (warmedUp) {
+                peakResidentBytes = std::max(peakResidentBytes, usage.residentBytes);
+            }
+            if (now - budgetStartTime >= k_budgetInterval) {
+                double percent = 100 * (usage.cpuSeconds - budgetStart.cpuSeconds) / (now - budgetStartTime);
+                if (options.cpuBudget > 0 && percent > options.cpuBudget) {
+                    std::cerr << "Using " << std::fixed << std::setprecision(1) << percent
+                              << "% CPU, over the budget of " << options.cpuBudget << "%" << std::endl;
+                }
+                if (warmedUp && budgetStartTime >= soakStartTime) {
+                    peakCPUPercent = std::max(peakCPUPercent, percent);
+                }
+                budgetStart = usage;
+                budgetStartTime = now;
+            }
+        }
+
+        if (soak && now - startTime >= options.soakSeconds) {
+            break;
+        }
+    }
+
+    if (syntheticInput) {
+        syntheticInput->stop();
+    } else {
+        audioBackend->end();
+    }
+    analyzer.stop();
+
+    if (!soak) {
+        return 0;
+    }
+
+    // The analysis thread has stopped, so the Ingress is safe to read here.
+    IngressStats stats = ingress.getStats();
+    ProcessUsage end = ProcessUsage::measure();
+    double endTime = getSteadyTime();
+    if (!warmedUp) {
+        soakStart = end;
+        soakStartTime = endTime;
+    }
+    peakResidentBytes = std::max(peakResidentBytes, end.residentBytes);
+    double meanCPUPercent = endTime > soakStartTime
+        ? 100 * (end.cpuSeconds - soakStart.cpuSeconds) / (endTime - soakStartTime)
+        : 0;
+    bool memoryBounded = end.residentBytes <= soakStart.residentBytes + k_soakMemoryTolerance;
+    bool cpuBounded = options.cpuBudget <= 0 || meanCPUPercent <= options.cpuBudget;
+    bool keptUp = stats.droppedFrames == 0;
+
+    std::cerr << std::fixed << std::setprecision(1)
+              << "Soak test: " << (endTime - startTime) << " s, "
+              << syntheticInput->getFrames() / sampleRate << " s of audio at "
+              << options.soakSpeed << "x real time" << std::endl
+              << "Resident memory: " << toMiB(soakStart.residentBytes) << " MiB after warm-up, "
+              << toMiB(end.residentBytes) << " MiB at the end, " << toMiB(peakResidentBytes)
+              << " MiB at most" << (memoryBounded ? "" : " (grew)") << std::endl
+              << "CPU: " << meanCPUPercent << "% of a core on average, " << peakCPUPercent
+              << "% at most over " << k_budgetInterval << " s";
+    if (options.cpuBudget > 0) {
+        std::cerr << ", budget " << options.cpuBudget << "%" << (cpuBounded ? "" : " (over)");
+    }
+    std::cerr << std::endl
+              << "Dropped frames: " << stats.droppedFrames << std::endl
+              << (memoryBounded && cpuBounded && keptUp ? "PASS" : "FAIL") << std::endl;
+    return memoryBounded && cpuBounded && keptUp ? 0 : 1;
+}
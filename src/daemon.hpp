@@ -0,0 +1,13 @@
+#pragma once
+#include "Options.hpp"
+
+// Runs the analysis around the clock without a window, for --no-display:
+// audio from the device through the Ingress, the analysis engine and the
+// accumulators, out to a JSON Lines file or stdout (see SpectrumWriter) and
+// to shared memory. Nothing here touches OpenGL or GLFW, so it also builds
+// into nicescope_daemon, which does not link them.
+//
+// Stops on SIGINT or SIGTERM, or at the end of a soak test. SIGHUP reopens
+// the output file, for log rotation. Returns the exit status, which for a
+// soak test says whether it passed.
+int runDaemon(const Options& options);
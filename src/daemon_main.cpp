@@ -0,0 +1,9 @@
+#include "daemon.hpp"
+
+// nicescope_daemon: NiceScope --no-display, in a binary that does not link
+// OpenGL or GLFW, for machines without a display.
+int main(int argc, char** argv)
+{
+    Options options = parseOptions(argc, argv, true);
+    return runDaemon(options);
+}
@@ -1,26 +1,39 @@
 #include "main.hpp"
 
-static std::array<float, 4> colorFromHex(int string, float alpha)
-{
-    return { { (string >> (4 * 4) & 0xff) / 255.0f,
-        (string >> (2 * 4) & 0xff) / 255.0f,
-        (string & 0xff) / 255.0f,
-        alpha } };
-}
+volatile int g_windowWidth = 640;
+volatile int g_windowHeight = 480;
 
-static std::array<float, 4> colorFromHex(int string)
+// Resizing only records the new framebuffer size, which every frame is drawn
+// at. The views are laid out for it once there has been no resize for
+// k_layoutDelay, so dragging a window edge re-chunks the curves once rather
+// than on every event.
+static const std::chrono::milliseconds k_layoutDelay(150);
+// The window aims for this many frames per second, but vsync and the
+// scheduler decide, so it measures the time between frames. Each headless
+// frame stands for this much audio.
+static const int k_frameRate = 60;
+static float g_contentScale = 1;
+static bool g_layoutPending = false;
+static std::chrono::steady_clock::time_point g_lastLayoutChange;
+
+static void requestLayout()
 {
-    return colorFromHex(string, 1.0f);
+    g_layoutPending = true;
+    g_lastLayoutChange = std::chrono::steady_clock::now();
 }
 
-volatile int g_windowWidth = 640;
-volatile int g_windowHeight = 480;
-
 static void resize(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, (GLsizei)width, (GLsizei)height);
     g_windowWidth = width;
     g_windowHeight = height;
+    requestLayout();
+}
+
+static void changeContentScale(GLFWwindow* window, float xScale, float yScale)
+{
+    g_contentScale = xScale;
+    requestLayout();
 }
 
 GLFWwindow* setUpWindowAndOpenGL(const char* windowTitle)
@@ -63,88 +76,327 @@ MinimalOpenGLApp::MinimalOpenGLApp(GLFWwindow* window)
 {
     m_window = window;
     glfwSetFramebufferSizeCallback(m_window, resize);
+    glfwSetWindowContentScaleCallback(m_window, changeContentScale);
+
+    // The window was created in screen coordinates, which on a HiDPI
+    // display are not pixels.
+    int width;
+    int height;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    g_windowWidth = width;
+    g_windowHeight = height;
+    float yScale;
+    glfwGetWindowContentScale(m_window, &g_contentScale, &yScale);
 }
 
-int main(int argc, char** argv)
+void Views::setContentScale(float contentScale)
 {
-    std::string device = "system";
-
-    int i = 1;
-    while (i < argc) {
-        std::string arg = argv[i];
-        if (arg == "--device") {
-            i++;
-            if (i >= argc) {
-                throw std::runtime_error("Unexpected end of arguments");
-            }
-            device = argv[i];
-        } else {
-            throw std::runtime_error("Unrecognized argument");
+    spectrum->setContentScale(contentScale);
+}
+
+void Views::setWindowSize(int width, int height)
+{
+    spectrum->setWindowSize(width - getGoniometerSize(width, height), height - getWaveformHeight(height));
+}
+
+void Views::render(const AnalysisFrame& frame)
+{
+    int width = g_windowWidth;
+    int height = g_windowHeight;
+    int goniometerSize = getGoniometerSize(width, height);
+    if (goniometer) {
+        goniometer->render(width - goniometerSize, height - goniometerSize, goniometerSize);
+    }
+    int leftWidth = width - goniometerSize;
+    int waveformHeight = getWaveformHeight(height);
+    if (waveform) {
+        waveform->render(0, leftWidth, waveformHeight);
+    }
+    spectrum->render(frame, waveformHeight, leftWidth, height - waveformHeight);
+    glViewport(0, 0, width, height);
+}
+
+ViewSet::ViewSet(
+    const Options& options,
+    const std::vector<float>& binFrequencies,
+    float lowestFrequency,
+    float highestFrequency,
+    const std::vector<AccumulatorKind>& traces,
+    float sampleRate,
+    float frameRate)
+    // Interpolate and extrude the curves on the GPU where the context allows
+    // it, else fall back to doing it on the CPU.
+    : spectrum(
+        binFrequencies,
+        options.numChannels,
+        lowestFrequency,
+        highestFrequency,
+        !options.cpuCurves && ScopeRenderer::supportsGPUCurves(),
+        options.waterfallRows,
+        options.persistence,
+        1 / frameRate,
+        traces)
+    // A quarter second of slack between the analysis and render threads.
+    , waveformTap(options.numChannels, static_cast<int>(sampleRate / 4))
+    , goniometerTap(options.numChannels, static_cast<int>(sampleRate / 4))
+{
+    if (options.waveformSpan > 0) {
+        waveform.reset(new WaveformView(waveformTap, options.numChannels, sampleRate, options.waveformSpan));
+    }
+    if (options.goniometerPoints > 0) {
+        if (!GoniometerView::isSupported()) {
+            throw std::runtime_error("The goniometer needs OpenGL 3.1.");
         }
-        i++;
+        goniometer.reset(new GoniometerView(
+            goniometerTap, options.numChannels, sampleRate, options.goniometerPoints, colorFromHex(k_backgroundColor)));
     }
+    views = { &spectrum, waveform.get(), goniometer.get() };
+}
 
-    auto window = setUpWindowAndOpenGL("Scope");
-    MinimalOpenGLApp app(window);
+static void reportTriggerStats(const TriggerStats& stats, TriggerStats& lastReported)
+{
+    if (stats.missedTriggers == lastReported.missedTriggers) {
+        return;
+    }
+    std::cerr << "Trigger fired " << stats.triggers << " times and missed "
+              << stats.missedTriggers << " edges that came while a capture was still filling" << std::endl;
+    lastReported = stats;
+}
 
-    int fftSize = 2048;
+static void runWindow(const Options& options, GLFWwindow* window, Analyzer& analyzer, Views& views, Trigger* trigger)
+{
+    IngressStats lastReportedStats;
+    TriggerStats lastReportedTriggerStats;
+    auto lastStatsReport = std::chrono::steady_clock::now();
+    bool resetKeyWasDown = false;
+    Telemetry telemetry;
+    bool showStats = options.stats;
+    bool statsKeyWasDown = false;
+    bool statsFileFailing = false;
+    double lastFrameStart = getSteadyTime();
 
-    Spectrum spectrumLeft(fftSize, 2, 0.1, 1.5);
-    spectrumLeft.setWindowSize(g_windowWidth, g_windowHeight);
-    Scope scopeLeft(spectrumLeft.getNumPlotPoints(), colorFromHex(0xf0c674, 0.8), 8.0);
+    while (!glfwWindowShouldClose(window)) {
+        if (g_layoutPending && std::chrono::steady_clock::now() - g_lastLayoutChange >= k_layoutDelay) {
+            g_layoutPending = false;
+            views.setContentScale(g_contentScale);
+            views.setWindowSize(g_windowWidth, g_windowHeight);
+        }
 
-    Spectrum spectrumRight(fftSize, 2, 0.1, 1.5);
-    spectrumRight.setWindowSize(g_windowWidth, g_windowHeight);
-    Scope scopeRight(spectrumRight.getNumPlotPoints(), colorFromHex(0x8abeb7, 0.8), 8.0);
+        double frameStart = getSteadyTime();
+        // The persistence trail fades by the time that actually passed.
+        views.spectrum->setFrameInterval(frameStart - lastFrameStart);
+        lastFrameStart = frameStart;
+        glClear(GL_COLOR_BUFFER_BIT);
 
-    Spectrum spectrum2(fftSize, 2, 3, 5);
-    spectrum2.setWindowSize(g_windowWidth, g_windowHeight);
-    Scope scope2(spectrum2.getNumPlotPoints(), colorFromHex(0x3c3d3b), 8.0);
+        bool newFrame = analyzer.update();
+        const AnalysisFrame& frame = analyzer.getFrame();
 
-    FFT fftLeft(fftSize, 0);
-    FFT fftRight(fftSize, 1);
-    SpectralMaximum spectralMaximum(fftLeft.getSpectrumSize());
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastStatsReport >= std::chrono::seconds(1)) {
+            reportIngressStats(frame.ingressStats, lastReportedStats);
+            if (trigger) {
+                reportTriggerStats(trigger->getStats(), lastReportedTriggerStats);
+            }
+            if (showStats) {
+                glfwSetWindowTitle(window, ("Scope: " + telemetry.getSummary()).c_str());
+            }
+            // A full disk or an unwritable path must not take the scope
+            // down. The write is retried every second, and each failure
+            // streak is reported once.
+            if (!options.statsFile.empty()) {
+                try {
+                    telemetry.writeJSONFile(options.statsFile);
+                    statsFileFailing = false;
+                } catch (const std::runtime_error& error) {
+                    if (!statsFileFailing) {
+                        std::cerr << error.what() << std::endl;
+                    }
+                    statsFileFailing = true;
+                }
+            }
+            lastStatsReport = now;
+        }
 
-    RangeComputer rangeComputer;
+        views.render(frame);
 
-    Ingress callback(2, fftSize);
+        glfwSwapBuffers(window);
+        double presentTime = getSteadyTime();
+        telemetry.addPresentedFrame(frame, newFrame, presentTime - frameStart, presentTime);
+        glfwPollEvents();
 
-    PortAudioBackend audioBackend(&callback, device, 2);
-    audioBackend.run();
+        // R starts the peak holds and averages over.
+        bool resetKeyIsDown = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+        if (resetKeyIsDown && !resetKeyWasDown) {
+            analyzer.resetAccumulators();
+        }
+        resetKeyWasDown = resetKeyIsDown;
+
+        // S shows or hides the stats in the title.
+        bool statsKeyIsDown = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+        if (statsKeyIsDown && !statsKeyWasDown) {
+            showStats = !showStats;
+            if (!showStats) {
+                glfwSetWindowTitle(window, "Scope");
+            }
+        }
+        statsKeyWasDown = statsKeyIsDown;
 
-    std::array<float, 4> color = colorFromHex(0x1d1f21);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / k_frameRate));
+    }
+}
 
-    glClearColor(color[0], color[1], color[2], color[3]);
+// Renders as fast as possible, standing in for the audio device by pushing
+// a video frame's worth of synthetic audio into the Ingress before each
+// frame. A frame's CPU time covers taking the latest analysis, updating the
+// curves and submitting the draw; glFinish() at the end of the frame keeps
+// the GPU from queueing up work across frames. Blocks are stamped as if
+// captured when they are pushed, so the latency in the stats is the
+// pipeline's own, without any audio buffering.
+static void runHeadless(const Options& options, Ingress& ingress, Analyzer& analyzer, Views& views, float sampleRate)
+{
+    const int blockSize = 256;
+    const int framesPerVideoFrame = static_cast<int>(sampleRate / k_frameRate);
+    const int warmUpFrames = std::min(10, options.headlessFrames / 2);
+
+    SyntheticSource source(options.numChannels, sampleRate);
+    std::vector<float> block(blockSize * options.numChannels);
+    FrameTimer timer(warmUpFrames);
+    Telemetry telemetry;
+
+    for (int videoFrame = 0; videoFrame < options.headlessFrames; videoFrame++) {
+        for (int done = 0; done < framesPerVideoFrame; done += blockSize) {
+            int numFrames = std::min(blockSize, framesPerVideoFrame - done);
+            source.generate(block.data(), numFrames);
+            ingress.process(block.data(), nullptr, numFrames, 0, getSteadyTime() - numFrames / sampleRate);
+        }
 
-    while (!glfwWindowShouldClose(window)) {
+        double frameStart = getSteadyTime();
+        timer.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT);
+        bool newFrame = analyzer.update();
+        const AnalysisFrame& frame = analyzer.getFrame();
+        views.render(frame);
+        timer.endFrame();
+        glFinish();
+        double presentTime = getSteadyTime();
+        telemetry.addPresentedFrame(frame, newFrame, presentTime - frameStart, presentTime);
+    }
+    timer.finish();
 
-        callback.bufferSamples();
+    std::cout << options.width << "x" << options.height << ", "
+              << (views.spectrum->usesGPUCurves() ? "GPU" : "CPU") << " curves" << std::endl;
+    timer.report(std::cout);
+    if (options.stats) {
+        std::cout << telemetry.getSummary() << std::endl;
+    }
+    if (!options.statsFile.empty()) {
+        telemetry.writeJSONFile(options.statsFile);
+    }
+}
 
-        fftLeft.process(callback);
-        fftRight.process(callback);
-        spectralMaximum.set(fftLeft.getMagnitudeSpectrum());
-        spectralMaximum.computeMaximumWith(fftRight.getMagnitudeSpectrum());
-        rangeComputer.process(spectralMaximum.getMaximum());
+int main(int argc, char** argv)
+{
+    Options options = parseOptions(argc, argv);
+
+    FFTWisdom wisdom;
+    wisdom.load();
+    if (options.prewarm) {
+        std::vector<int> channelCounts = { 1 };
+        if (options.numChannels != 1) {
+            channelCounts.push_back(options.numChannels);
+        }
+        wisdom.prewarm(channelCounts, options.planEffort);
+        return 0;
+    }
+    if (options.noDisplay) {
+        return runDaemon(options);
+    }
+    if (!options.inputPath.empty()) {
+        runOffline(options);
+        return 0;
+    }
 
-        spectrum2.update(spectralMaximum.getMagnitudeSpectrum());
-        scope2.plotFilled(rangeComputer, spectrum2.getPlotX(), spectrum2.getPlotY());
-        scope2.render();
+    g_windowWidth = options.width;
+    g_windowHeight = options.height;
+
+    std::unique_ptr<HeadlessContext> headlessContext;
+    GLFWwindow* window = nullptr;
+    std::unique_ptr<MinimalOpenGLApp> app;
+    if (options.headless) {
+        headlessContext.reset(new HeadlessContext(options.width, options.height));
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_BLEND);
+    } else {
+        window = setUpWindowAndOpenGL("Scope");
+        app.reset(new MinimalOpenGLApp(window));
+    }
 
-        spectrumLeft.update(fftLeft.getMagnitudeSpectrum());
-        scopeLeft.plot(rangeComputer, spectrumLeft.getPlotX(), spectrumLeft.getPlotY(), spectrumLeft.getPlotNormal());
-        scopeLeft.render();
+    const float sampleRate = PortAudioBackend::k_sampleRate;
+
+    LiveAnalysis analysis(options, sampleRate, wisdom);
+    Ingress& callback = analysis.getIngress();
+    Analyzer& analyzer = analysis.getAnalyzer();
+    float lowestFrequency = analysis.getLowestFrequency();
+    float highestFrequency = analysis.getHighestFrequency();
+
+    // The capture fills the waveform view, a quarter of it before the edge.
+    std::unique_ptr<Trigger> trigger;
+    if (options.trigger) {
+        TriggerSettings settings = options.triggerSettings;
+        int captureFrames = std::max(2, static_cast<int>(options.waveformSpan * sampleRate));
+        settings.preTriggerFrames = captureFrames / 4;
+        settings.postTriggerFrames = captureFrames - settings.preTriggerFrames;
+        settings.holdoff = static_cast<int>(options.triggerHoldoffSeconds * sampleRate);
+        trigger.reset(new Trigger(options.numChannels, settings));
+        callback.setTrigger(trigger.get());
+    }
 
-        spectrumRight.update(fftRight.getMagnitudeSpectrum());
-        scopeRight.plot(rangeComputer, spectrumRight.getPlotX(), spectrumRight.getPlotY(), spectrumRight.getPlotNormal());
-        scopeRight.render();
+    std::unique_ptr<PortAudioBackend> audioBackend;
+    if (!options.headless) {
+        audioBackend.reset(new PortAudioBackend(&callback, options.device, options.numChannels));
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    ViewSet viewSet(
+        options,
+        analyzer.getBinFrequencies(),
+        lowestFrequency,
+        highestFrequency,
+        analyzer.getAccumulatorKinds(),
+        sampleRate,
+        k_frameRate);
+    if (viewSet.waveform) {
+        if (trigger) {
+            viewSet.waveform->setTrigger(*trigger);
+        } else {
+            analyzer.addTap(viewSet.waveformTap);
+        }
+    }
+    if (viewSet.goniometer) {
+        analyzer.addTap(viewSet.goniometerTap);
+    }
+
+    Views& views = viewSet.views;
+    views.setContentScale(g_contentScale);
+    views.setWindowSize(g_windowWidth, g_windowHeight);
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 60));
+    analyzer.start();
+    if (audioBackend) {
+        audioBackend->run();
     }
 
-    glfwTerminate();
+    std::array<float, 4> color = colorFromHex(k_backgroundColor);
+
+    glClearColor(color[0], color[1], color[2], color[3]);
+
+    if (options.headless) {
+        runHeadless(options, callback, analyzer, views, sampleRate);
+    } else {
+        runWindow(options, window, analyzer, views, trigger.get());
+    }
+
+    analyzer.stop();
+    if (window) {
+        glfwTerminate();
+    }
     return 0;
 }
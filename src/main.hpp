@@ -3,19 +3,84 @@
 #include <stdexcept>
 #include <thread>
 #include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "Analyzer.hpp"
+#include "Clock.hpp"
+#include "daemon.hpp"
+#include "offline.hpp"
 #include "FFT.hpp"
-#include "Scope.hpp"
+#include "FFTWisdom.hpp"
+#include "FrameTimer.hpp"
+#include "GoniometerView.hpp"
+#include "HeadlessContext.hpp"
+#include "LiveAnalysis.hpp"
+#include "MultiResolutionFFT.hpp"
+#include "Options.hpp"
+#include "PersistenceBuffer.hpp"
+#include "ScopeRenderer.hpp"
 #include "ShaderProgram.hpp"
+#include "SlidingDFT.hpp"
 #include "Spectrum.hpp"
+#include "SpectrumView.hpp"
+#include "SyntheticSource.hpp"
+#include "Telemetry.hpp"
+#include "Trigger.hpp"
+#include "WaterfallRenderer.hpp"
+#include "WaveformView.hpp"
+#include "ZoomFFT.hpp"
 #include "portaudio_backend.hpp"
 
 extern volatile int g_windowWidth;
 extern volatile int g_windowHeight;
 
+// Everything drawn in the window. On the left, stacked bottom to top, the
+// waveform, if there is one, then the spectrum view. On the right, the
+// goniometer, if there is one, as a square.
+struct Views {
+    SpectrumView* spectrum;
+    WaveformView* waveform;
+    GoniometerView* goniometer;
+
+    int getWaveformHeight(int height) { return waveform ? height / 3 : 0; }
+    int getGoniometerSize(int width, int height) { return goniometer ? std::min(height, width / 3) : 0; }
+    void setContentScale(float contentScale);
+    void setWindowSize(int width, int height);
+    void render(const AnalysisFrame& frame);
+};
+
+// The views the options ask for, and the taps that feed the waveform and
+// goniometer views with audio. The taps are left unconnected. frameRate is
+// how often the views are drawn, or how often they are expected to be until
+// the caller reports the measured interval to the SpectrumView.
+// Over-aligned because of the taps, so not to be allocated with new.
+struct ViewSet {
+    ViewSet(
+        const Options& options,
+        const std::vector<float>& binFrequencies,
+        float lowestFrequency,
+        float highestFrequency,
+        const std::vector<AccumulatorKind>& traces,
+        float sampleRate,
+        float frameRate);
+
+    ViewSet(const ViewSet& other) = delete;
+    ViewSet& operator=(const ViewSet& other) = delete;
+
+    SpectrumView spectrum;
+    SPSCRing waveformTap;
+    std::unique_ptr<WaveformView> waveform;
+    SPSCRing goniometerTap;
+    std::unique_ptr<GoniometerView> goniometer;
+    Views views;
+};
+
 class MinimalOpenGLApp {
 public:
     MinimalOpenGLApp(GLFWwindow* window);
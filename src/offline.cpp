@@ -0,0 +1,377 @@
+#include "offline.hpp"
+#include "Colors.hpp"
+#include "OfflineAnalysis.hpp"
+#include "main.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+
+// Writes rendered frames out on a thread of its own. Frames arrive as
+// glReadPixels() leaves them, RGB with the bottom row first, and go out
+// top row first: as numbered binary PPM images, and as a raw RGB stream
+// that video encoders can take, e.g. ffmpeg -f rawvideo -pix_fmt rgb24.
+class FrameWriter {
+public:
+    FrameWriter(const std::string& imagePrefix, const std::string& videoPath, int width, int height);
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter& other) = delete;
+    FrameWriter& operator=(const FrameWriter& other) = delete;
+
+    bool isEnabled() const { return !m_imagePrefix.empty() || m_video; }
+
+    // A buffer for the next frame, waiting while every buffer is queued.
+    std::vector<unsigned char>& acquire();
+    // Queues the buffer from the last acquire(). Throws if a write failed.
+    void submit();
+    // Writes out everything queued. Throws if a write failed.
+    void finish();
+
+private:
+    static const int k_numBuffers = 4;
+
+    const std::string m_imagePrefix;
+    const int m_width;
+    const int m_height;
+    FILE* m_video = nullptr;
+
+    std::vector<std::vector<unsigned char>> m_buffers;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<int> m_free;
+    std::deque<int> m_queued;
+    int m_acquired = -1;
+    uint64_t m_numWritten = 0;
+    bool m_finishing = false;
+    std::string m_error;
+    std::thread m_thread;
+
+    void run();
+    void write(const std::vector<unsigned char>& pixels);
+};
+
+FrameWriter::FrameWriter(const std::string& imagePrefix, const std::string& videoPath, int width, int height)
+    : m_imagePrefix(imagePrefix)
+    , m_width(width)
+    , m_height(height)
+    , m_buffers(k_numBuffers, std::vector<unsigned char>(3 * width * height))
+{
+    if (videoPath == "-") {
+        m_video = stdout;
+    } else if (!videoPath.empty()) {
+        m_video = std::fopen(videoPath.c_str(), "wb");
+        if (!m_video) {
+            throw std::runtime_error("Could not open " + videoPath);
+        }
+    }
+    for (int i = 0; i < k_numBuffers; i++) {
+        m_free.push_back(i);
+    }
+    m_thread = std::thread(&FrameWriter::run, this);
+}
+
+FrameWriter::~FrameWriter()
+{
+    try {
+        finish();
+    } catch (const std::runtime_error&) {
+    }
+}
+
+std::vector<unsigned char>& FrameWriter::acquire()
+{
+    if (m_acquired < 0) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [&] { return !m_free.empty(); });
+        m_acquired = m_free.front();
+        m_free.pop_front();
+    }
+    return m_buffers[m_acquired];
+}
+
+void FrameWriter::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_error.empty()) {
+            throw std::runtime_error(m_error);
+        }
+        m_queued.push_back(m_acquired);
+    }
+    m_acquired = -1;
+    m_changed.notify_all();
+}
+
+void FrameWriter::finish()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finishing = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+    if (m_video && (std::fflush(m_video) != 0 || std::ferror(m_video)) && m_error.empty()) {
+        m_error = "Could not write the video";
+    }
+    if (m_video && m_video != stdout) {
+        std::fclose(m_video);
+    }
+    m_video = nullptr;
+    if (!m_error.empty()) {
+        throw std::runtime_error(m_error);
+    }
+}
+
+void FrameWriter::run()
+{
+    while (true) {
+        int buffer;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&] { return m_finishing || !m_queued.empty(); });
+            if (m_queued.empty()) {
+                return;
+            }
+            buffer = m_queued.front();
+            m_queued.pop_front();
+        }
+        write(m_buffers[buffer]);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(buffer);
+        }
+        m_changed.notify_all();
+    }
+}
+
+void FrameWriter::write(const std::vector<unsigned char>& pixels)
+{
+    // After a failure, frames are only passed through, so the renderer
+    // does not block before it finds out.
+    if (!m_error.empty()) {
+        return;
+    }
+    const size_t rowSize = 3 * m_width;
+
+    if (!m_imagePrefix.empty()) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%06llu.ppm", static_cast<unsigned long long>(m_numWritten));
+        std::string path = m_imagePrefix + number;
+        FILE* image = std::fopen(path.c_str(), "wb");
+        bool written = image && std::fprintf(image, "P6\n%d %d\n255\n", m_width, m_height) > 0;
+        for (int y = m_height - 1; written && y >= 0; y--) {
+            written = std::fwrite(&pixels[y * rowSize], 1, rowSize, image) == rowSize;
+        }
+        if (image && std::fclose(image) != 0) {
+            written = false;
+        }
+        if (!written) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = "Could not write " + path;
+            return;
+        }
+    }
+
+    if (m_video) {
+        for (int y = m_height - 1; y >= 0; y--) {
+            if (std::fwrite(&pixels[y * rowSize], 1, rowSize, m_video) != rowSize) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_error = "Could not write the video";
+                return;
+            }
+        }
+    }
+    m_numWritten++;
+}
+
+// Reads frames back through two pixel buffer objects in turn, so that
+// copying one frame out overlaps rendering the next instead of stalling
+// until the GPU is done.
+class PixelReader {
+public:
+    PixelReader(int width, int height)
+        : m_width(width)
+        , m_height(height)
+    {
+        glGenBuffers(2, m_buffers);
+        for (GLuint buffer : m_buffers) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, 3 * width * height, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    }
+
+    ~PixelReader() { glDeleteBuffers(2, m_buffers); }
+
+    PixelReader(const PixelReader& other) = delete;
+    PixelReader& operator=(const PixelReader& other) = delete;
+
+    // Starts reading back the frame just rendered.
+    void start()
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_next]);
+        glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_pending[m_next] = true;
+        m_next = 1 - m_next;
+    }
+
+    // Copies out the older of the frames being read back, if there is one.
+    bool collect(std::vector<unsigned char>& pixels) { return collect(m_next, pixels); }
+    // Copies out the frame started last, if it was not collected yet.
+    bool collectLast(std::vector<unsigned char>& pixels) { return collect(1 - m_next, pixels); }
+
+private:
+    const int m_width;
+    const int m_height;
+    GLuint m_buffers[2];
+    bool m_pending[2] = { false, false };
+    int m_next = 0;
+
+    bool collect(int index, std::vector<unsigned char>& pixels)
+    {
+        if (!m_pending[index]) {
+            return false;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[index]);
+        const void* data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (data) {
+            std::memcpy(pixels.data(), data, pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_pending[index] = false;
+        if (!data) {
+            throw std::runtime_error("Could not read back a frame");
+        }
+        return true;
+    }
+};
+
+void runOffline(const Options& commandLineOptions)
+{
+    Options options = commandLineOptions;
+    std::unique_ptr<AudioFile> file(options.rawSampleRate > 0
+            ? new AudioFile(options.inputPath, options.numChannels, options.rawSampleRate, options.rawFormat)
+            : new AudioFile(options.inputPath));
+    options.numChannels = file->getNumChannels();
+    const float sampleRate = file->getSampleRate();
+
+    g_windowWidth = options.width;
+    g_windowHeight = options.height;
+    HeadlessContext context(options.width, options.height);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_BLEND);
+    std::array<float, 4> color = colorFromHex(k_backgroundColor);
+    glClearColor(color[0], color[1], color[2], color[3]);
+
+    int numThreads = options.analysisThreads;
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    FFTWisdom wisdom;
+    wisdom.load();
+    OfflineAnalysis analysis(
+        *file, [&] { return makeAnalysisEngine(options, sampleRate); }, numThreads);
+    wisdom.save();
+    AnalysisEngine& engine = analysis.getEngine();
+    const int hopSize = engine.getHopSize();
+
+    FrameBuilder frameBuilder(options.numChannels, engine.getSpectrumSize(), options.accumulators);
+    AnalysisFrame frame = frameBuilder.makeEmptyFrame();
+
+    ViewSet viewSet(
+        options,
+        engine.getBinFrequencies(),
+        engine.getLowestFrequency(),
+        engine.getHighestFrequency(),
+        frameBuilder.getAccumulatorKinds(),
+        sampleRate,
+        options.frameRate);
+    Views& views = viewSet.views;
+    views.setWindowSize(options.width, options.height);
+    std::vector<float> audio(hopSize * options.numChannels);
+
+    FrameWriter writer(options.imagePrefix, options.videoPath, options.width, options.height);
+    std::unique_ptr<PixelReader> reader;
+    if (writer.isEnabled()) {
+        reader.reset(new PixelReader(options.width, options.height));
+    }
+
+    const uint64_t numVideoFrames = static_cast<uint64_t>(
+        std::ceil(file->getNumFrames() / static_cast<double>(sampleRate) * options.frameRate));
+    uint64_t videoFrame = 0;
+    // Each video frame shows every spectrum that ended before its time, and
+    // the views are fed the audio up to there.
+    auto renderUntil = [&](uint64_t endFrame) {
+        while (videoFrame < numVideoFrames && videoFrame * static_cast<double>(sampleRate) / options.frameRate < endFrame) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            views.render(frame);
+            if (reader) {
+                reader->start();
+                if (reader->collect(writer.acquire())) {
+                    writer.submit();
+                }
+            }
+            videoFrame++;
+        }
+    };
+
+    const double startTime = getSteadyTime();
+    double nextProgress = startTime + 2;
+    uint64_t framesSinceSpectrum = 0;
+    for (uint64_t hop = 0; hop < analysis.getNumHops(); hop++) {
+        renderUntil((hop + 1) * hopSize);
+
+        if (viewSet.waveform || viewSet.goniometer) {
+            file->read(hop * hopSize, hopSize, audio.data());
+            if (viewSet.waveform) {
+                viewSet.waveformTap.write(audio.data(), hopSize);
+            }
+            if (viewSet.goniometer) {
+                viewSet.goniometerTap.write(audio.data(), hopSize);
+            }
+        }
+
+        framesSinceSpectrum += hopSize;
+        const float* magnitudes = analysis.getHop(hop);
+        if (magnitudes) {
+            frameBuilder.build(magnitudes, framesSinceSpectrum / sampleRate, frame);
+            framesSinceSpectrum = 0;
+        }
+
+        double now = getSteadyTime();
+        if (now >= nextProgress) {
+            nextProgress = now + 2;
+            std::cerr << "Rendered " << videoFrame << " of " << numVideoFrames << " frames, "
+                      << std::fixed << std::setprecision(1)
+                      << (hop + 1) * hopSize / sampleRate / (now - startTime) << "x real time" << std::endl;
+        }
+    }
+    renderUntil(UINT64_MAX);
+    if (reader && reader->collectLast(writer.acquire())) {
+        writer.submit();
+    }
+    writer.finish();
+
+    double seconds = getSteadyTime() - startTime;
+    double audioSeconds = file->getNumFrames() / sampleRate;
+    // Keeps stdout clean when the video goes there.
+    std::ostream& summary = options.videoPath == "-" ? std::cerr : std::cout;
+    summary << std::fixed << std::setprecision(1)
+            << "Analyzed " << audioSeconds << " s of audio on " << analysis.getNumThreads()
+            << " threads and rendered " << numVideoFrames << " frames at "
+            << options.width << "x" << options.height << " in " << seconds << " s: "
+            << audioSeconds / seconds << "x real time, " << numVideoFrames / seconds
+            << " frames per second" << std::endl;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "Options.hpp"
+
+// Analyzes a recording (--input) as fast as the machine allows and renders
+// it offscreen at options.frameRate through the same views as the window,
+// out to images, raw video, or nowhere, for timing. OfflineAnalysis spreads
+// the analysis over every core; the accumulators and views take its spectra
+// in order on this thread, and another thread writes the frames out, so
+// rendering never waits on the disk. Needs EGL, like --headless.
+void runOffline(const Options& options);
@@ -1,4 +1,5 @@
 #include "portaudio_backend.hpp"
+#include "Clock.hpp"
 
 PortAudioBackend::PortAudioBackend(AudioCallback* callback, std::string device, int numChannels)
     : m_callback(callback)
@@ -45,9 +46,14 @@ void PortAudioBackend::end()
     handle_error(Pa_Terminate());
 }
 
-void PortAudioBackend::process(InputBuffer input_buffer, OutputBuffer output_buffer, int numFrames)
+void PortAudioBackend::process(
+    InputBuffer input_buffer,
+    OutputBuffer output_buffer,
+    int numFrames,
+    PaStreamCallbackFlags status_flags,
+    double adc_time)
 {
-    m_callback->process(input_buffer, output_buffer, numFrames);
+    m_callback->process(input_buffer, output_buffer, numFrames, status_flags, adc_time);
 }
 
 void PortAudioBackend::handle_error(PaError error)
@@ -106,9 +112,21 @@ int PortAudioBackend::stream_callback(
     void* userData)
 {
     PortAudioBackend* backend = static_cast<PortAudioBackend*>(userData);
+
+    // PortAudio's times are on the stream's own clock. Its distance from
+    // the ADC time to now carries over to the steady clock. Some host APIs
+    // leave the times at 0; then assume the block was captured just now.
+    double now = getSteadyTime();
+    double adc_time = now - frameCount / backend->m_sample_rate;
+    if (timeInfo && timeInfo->inputBufferAdcTime > 0 && timeInfo->currentTime >= timeInfo->inputBufferAdcTime) {
+        adc_time = now - (timeInfo->currentTime - timeInfo->inputBufferAdcTime);
+    }
+
     backend->process(
         static_cast<InputBuffer>(inputBuffer),
         static_cast<OutputBuffer>(outputBuffer),
-        frameCount);
+        frameCount,
+        statusFlags,
+        adc_time);
     return 0;
 }
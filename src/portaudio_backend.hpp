@@ -8,19 +8,33 @@ typedef float* OutputBuffer;
 
 class AudioCallback {
 public:
-    virtual void process(InputBuffer input_buffer, OutputBuffer output_buffer, int frame_count) = 0;
+    // adc_time is when the block's first frame was captured, on the clock
+    // of getSteadyTime().
+    virtual void process(
+        InputBuffer input_buffer,
+        OutputBuffer output_buffer,
+        int frame_count,
+        PaStreamCallbackFlags status_flags,
+        double adc_time)
+        = 0;
 };
 
 class PortAudioBackend {
 public:
     PortAudioBackend(AudioCallback* callback, std::string device, int numChannels);
 
+    static constexpr float k_sampleRate = 48000.0f;
+
+    float getSampleRate() { return m_sample_rate; }
+
     void run();
     void end();
     void process(
         InputBuffer input_buffer,
         OutputBuffer output_buffer,
-        int frame_count);
+        int frame_count,
+        PaStreamCallbackFlags status_flags,
+        double adc_time);
 
 private:
     AudioCallback* m_callback;
@@ -28,7 +42,7 @@ private:
     const int m_numChannels;
     PaSampleFormat sample_format;
     PaStream* m_stream;
-    const float m_sample_rate = 48000.0f;
+    const float m_sample_rate = k_sampleRate;
     const int m_block_size = 256;
     PaStreamParameters input_parameters;
     PaStreamParameters output_parameters;
@@ -0,0 +1,117 @@
+/*
+ * Follows a NiceScope shared-memory feed (NiceScope --shm <name>) from
+ * another process and prints one line per frame: its number, how long ago
+ * its newest sample was captured, and its loudest bin. Frames that were
+ * overwritten before they could be read are counted as skipped.
+ *
+ *     nicescope_shm_reader /nicescope [--count <frames>]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nicescope_shm.h"
+
+static double monotonic_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void sleep_briefly(void)
+{
+    struct timespec delay = { 0, 200000 };
+    nanosleep(&delay, NULL);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && !(argc == 4 && strcmp(argv[2], "--count") == 0)) {
+        fprintf(stderr, "Usage: %s <name> [--count <frames>]\n", argv[0]);
+        return 1;
+    }
+    long count = argc == 4 ? atol(argv[3]) : -1;
+
+    size_t size;
+    const nicescope_shm_header* header = nicescope_shm_attach(argv[1], &size);
+    if (!header) {
+        fprintf(stderr, "Could not attach to %s\n", argv[1]);
+        return 1;
+    }
+    printf(
+        "pid %d, %u channels, %u bins, %.0f Hz, %u slots\n",
+        (int)header->producer_pid,
+        header->num_channels,
+        header->spectrum_size,
+        header->sample_rate,
+        header->num_slots);
+    const float* frequencies = nicescope_shm_bin_frequencies(header);
+
+    uint64_t last = nicescope_shm_latest(header);
+    long read = 0;
+    unsigned long skipped = 0;
+    unsigned long retries = 0;
+    while (count < 0 || read < count) {
+        uint64_t latest = nicescope_shm_latest(header);
+        if (latest == last) {
+            sleep_briefly();
+            continue;
+        }
+        /* Read every frame since the last one that is still in the ring. */
+        uint64_t next = last + 1;
+        if (latest - next >= header->num_slots) {
+            skipped += latest - header->num_slots + 1 - next;
+            next = latest - header->num_slots + 1;
+        }
+
+        const nicescope_shm_slot* slot = nicescope_shm_slot_at(header, next);
+        uint64_t lock;
+        if (!nicescope_shm_begin_read(slot, &lock)) {
+            if (!nicescope_shm_producer_alive(header)) {
+                fprintf(stderr, "Producer %d died while writing a frame\n", (int)header->producer_pid);
+                munmap((void*)header, size);
+                return 1;
+            }
+            retries++;
+            sleep_briefly();
+            continue;
+        }
+        uint64_t sequence = slot->sequence;
+        double adc_time = slot->adc_time;
+        double publish_time = slot->publish_time;
+        float maximum = slot->maximum;
+        const float* magnitudes = nicescope_shm_magnitudes(header, slot, 0);
+        uint32_t peak = 0;
+        for (uint32_t bin = 1; bin < header->spectrum_size; bin++) {
+            if (magnitudes[bin] > magnitudes[peak]) {
+                peak = bin;
+            }
+        }
+        float peak_level = magnitudes[peak];
+        if (!nicescope_shm_end_read(slot, lock) || sequence != next) {
+            /* Overwritten while it was read. The next pass skips ahead. */
+            retries++;
+            continue;
+        }
+        double now = monotonic_time();
+
+        printf(
+            "%llu: %.2f ms since capture, %.2f ms since publish, peak %.1f Hz at %.1f dB (max %.1f dB)\n",
+            (unsigned long long)sequence,
+            1e3 * (now - adc_time),
+            1e3 * (now - publish_time),
+            frequencies[peak],
+            peak_level,
+            maximum);
+        last = next;
+        read++;
+    }
+    printf("%ld frames read, %lu skipped, %lu retried\n", read, skipped, retries);
+
+    munmap((void*)header, size);
+    return 0;
+}